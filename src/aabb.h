@@ -0,0 +1,32 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: aabb.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+
+namespace Shapes
+{
+	struct AABB
+	{
+		vec3 min;
+		vec3 max;
+
+		AABB();
+		AABB( const vec3& min, const vec3& max );
+
+		void	extend			( const vec3& point );
+		void	extend			( const AABB& other );
+		vec3	center			() const;
+		float	surface_area	() const;
+
+		bool	intersect		( const vec3& ray_pos, const vec3& inv_dir, const float t_max, float& t_entry ) const;
+	};
+}
@@ -0,0 +1,200 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: bvh.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/16/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	const unsigned	bin_count			= 16u;		// candidate split planes per axis
+	const unsigned	max_leaf_size		= 8u;		// leaves are split above this size even if SAH says otherwise
+	const float		traversal_cost		= 1.0f;		// cost of visiting a node relative to a primitive test
+	const float		intersection_cost	= 1.0f;
+}
+
+/**
+* @brief build the hierarchy over a set of primitives
+* @param bounds		bounding box of each primitive, the index in the vector identifies the primitive
+*/
+void BVH::build( const std::vector<Shapes::AABB>& bounds )
+{
+	clear();
+
+	if ( bounds.empty() )
+		return;
+
+	std::vector<vec3> centers( bounds.size() );
+	m_primitives.resize( bounds.size() );
+
+	for ( unsigned i = 0u; i < bounds.size(); i++ )
+	{
+		centers[i] = bounds[i].center();
+		m_primitives[i] = i;
+	}
+
+	m_nodes.reserve( 2u * bounds.size() );
+	build_node( bounds, centers, 0u, static_cast<unsigned>( bounds.size() ), 0u );
+}
+
+/**
+* @brief remove all the nodes
+*/
+void BVH::clear()
+{
+	m_nodes.clear();
+	m_primitives.clear();
+}
+
+/**
+* @brief recursively build a node for the primitives in [begin, end)
+* @param bounds		bounding box of each primitive
+* @param centers	center of the bounding box of each primitive
+* @param begin		first entry of the primitive list
+* @param end		last entry of the primitive list (not included)
+* @param depth		depth of the node
+* @return index of the node
+*/
+unsigned BVH::build_node( const std::vector<Shapes::AABB>& bounds, const std::vector<vec3>& centers, const unsigned begin, const unsigned end, const unsigned depth )
+{
+	const unsigned index = static_cast<unsigned>( m_nodes.size() );
+	m_nodes.push_back( Node() );
+
+	// bounds of the node and of the primitive centers
+	Shapes::AABB node_bounds;
+	Shapes::AABB center_bounds;
+	for ( unsigned i = begin; i < end; i++ )
+	{
+		node_bounds.extend( bounds[m_primitives[i]] );
+		center_bounds.extend( centers[m_primitives[i]] );
+	}
+
+	m_nodes[index].bounds	= node_bounds;
+	m_nodes[index].first	= begin;
+	m_nodes[index].count	= end - begin;
+
+	const unsigned count = end - begin;
+	if ( count == 1u || depth + 1u >= max_depth )
+		return index;
+
+	// find the cheapest split using binned SAH
+	const vec3 extent = center_bounds.max - center_bounds.min;
+
+	int		best_axis	= -1;
+	unsigned best_bin	= 0u;
+	float	best_cost	= std::numeric_limits<float>::max();
+
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		if ( extent[axis] <= 0.0f )
+			continue;
+
+		Shapes::AABB	bin_bounds[bin_count];
+		unsigned		bin_prims[bin_count] = {};
+
+		const float scale = static_cast<float>( bin_count ) / extent[axis];
+		for ( unsigned i = begin; i < end; i++ )
+		{
+			unsigned bin = static_cast<unsigned>( ( centers[m_primitives[i]][axis] - center_bounds.min[axis] ) * scale );
+			bin = std::min( bin, bin_count - 1u );
+
+			bin_bounds[bin].extend( bounds[m_primitives[i]] );
+			bin_prims[bin]++;
+		}
+
+		// sweep from the right to store the cost of the right side of every plane
+		float			right_area[bin_count];
+		unsigned		right_prims[bin_count];
+		Shapes::AABB	accum;
+		unsigned		accum_prims = 0u;
+		for ( unsigned bin = bin_count - 1u; bin > 0u; bin-- )
+		{
+			accum.extend( bin_bounds[bin] );
+			accum_prims += bin_prims[bin];
+			right_area[bin] = accum.surface_area();
+			right_prims[bin] = accum_prims;
+		}
+
+		// sweep from the left and evaluate each plane
+		accum = Shapes::AABB();
+		accum_prims = 0u;
+		for ( unsigned bin = 0u; bin < bin_count - 1u; bin++ )
+		{
+			accum.extend( bin_bounds[bin] );
+			accum_prims += bin_prims[bin];
+
+			float cost = accum.surface_area() * accum_prims + right_area[bin + 1u] * right_prims[bin + 1u];
+			if ( accum_prims != 0u && right_prims[bin + 1u] != 0u && cost < best_cost )
+			{
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = bin;
+			}
+		}
+	}
+
+	// all centers in the same spot -> nothing to split
+	if ( best_axis == -1 )
+		return index;
+
+	// compare against the cost of making a leaf
+	const float area = node_bounds.surface_area();
+	const float split_cost = traversal_cost + ( area > 0.0f ? best_cost / area : 0.0f ) * intersection_cost;
+	const float leaf_cost = count * intersection_cost;
+	if ( split_cost >= leaf_cost && count <= max_leaf_size )
+		return index;
+
+	// partition the primitives around the chosen plane
+	const float scale = static_cast<float>( bin_count ) / extent[best_axis];
+	const float min = center_bounds.min[best_axis];
+	auto middle = std::partition( m_primitives.begin() + begin, m_primitives.begin() + end, [&]( const unsigned primitive )
+	{
+		unsigned bin = static_cast<unsigned>( ( centers[primitive][best_axis] - min ) * scale );
+		return std::min( bin, bin_count - 1u ) <= best_bin;
+	} );
+	const unsigned split = static_cast<unsigned>( middle - m_primitives.begin() );
+
+	// children, the left one is always the next node
+	build_node( bounds, centers, begin, split, depth + 1u );
+	unsigned right = build_node( bounds, centers, split, end, depth + 1u );
+
+	m_nodes[index].first = right;
+	m_nodes[index].count = 0u;
+
+	return index;
+}
+
+/**
+* @brief check if the hierarchy was built
+* @return true if there are no nodes
+*/
+bool BVH::empty() const
+{
+	return m_nodes.empty();
+}
+
+/**
+* @brief get the nodes of the hierarchy, the root is the first one
+* @return nodes
+*/
+const std::vector<BVH::Node>& BVH::nodes() const
+{
+	return m_nodes;
+}
+
+/**
+* @brief get the primitive indices referenced by the leaves
+* @return primitives
+*/
+const std::vector<unsigned>& BVH::primitives() const
+{
+	return m_primitives;
+}
@@ -0,0 +1,331 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: bvh.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/16/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "ray.h"
+#include "aabb.h"
+#include "packet.h"
+#include "math_utils.h"
+#include <vector>
+
+/**
+* @brief bounding volume hierarchy built with the surface area heuristic
+*
+* The hierarchy only knows about the bounding boxes of the primitives, the caller
+* provides the intersection routine for a primitive while traversing.
+*/
+class BVH
+{
+	friend class SceneCache;	// stores the arrays as they are
+
+public:
+
+	struct Node
+	{
+		Shapes::AABB	bounds;
+		unsigned		first;	// leaf: first entry in the primitive list, interior: index of the right child
+		unsigned		count;	// leaf: amount of primitives, interior: 0 (left child is the next node)
+	};
+
+	static const unsigned max_depth = 64u;
+
+	void build( const std::vector<Shapes::AABB>& bounds );
+	void clear();
+
+	template <typename Intersect>
+	bool traverse( const Shapes::Ray& ray, float& t_max, Intersect intersect, const unsigned root = 0u ) const;
+
+	template <typename Intersect>
+	void traverse_packet( Packets::RayPacket& packet, Intersect intersect ) const;
+
+	template <typename Occluded>
+	bool occluded( const Shapes::Ray& ray, const float t_max, Occluded occluded ) const;
+
+	bool							empty		() const;
+	const std::vector<Node>&		nodes		() const;
+	const std::vector<unsigned>&	primitives	() const;
+
+	static bool		counts_visits	();
+	static size_t	node_visits		();
+
+private:
+
+	static void count_visit();
+
+	unsigned build_node( const std::vector<Shapes::AABB>& bounds, const std::vector<vec3>& centers, const unsigned begin, const unsigned end, const unsigned depth );
+
+private:
+	std::vector<Node>		m_nodes;
+	std::vector<unsigned>	m_primitives;
+
+	// nodes visited by the calling thread, every traversal of every hierarchy adds to it
+	static inline thread_local size_t s_node_visits = 0u;
+};
+
+/**
+* @brief check if the traversals count their node visits (built with CS500_TRAVERSAL_STATS)
+* @return true if node_visits is meaningful
+*/
+inline bool BVH::counts_visits()
+{
+#ifdef CS500_TRAVERSAL_STATS
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+* @brief get the nodes visited by the calling thread so far
+* @return amount of nodes, 0 if the visits are not counted
+*/
+inline size_t BVH::node_visits()
+{
+	return s_node_visits;
+}
+
+/**
+* @brief count a node visit of the calling thread, nothing unless built with CS500_TRAVERSAL_STATS
+*/
+inline void BVH::count_visit()
+{
+#ifdef CS500_TRAVERSAL_STATS
+	s_node_visits++;
+#endif
+}
+
+/**
+* @brief traverse the hierarchy front to back, skipping nodes farther than the closest hit
+* @param ray		the ray
+* @param t_max		maximum time accepted, updated by the intersection routine (return)
+* @param intersect	bool( unsigned primitive, float& t_max ), true if the primitive was hit closer than t_max
+* @param root		node to start from
+* @return true if any primitive was hit
+*/
+template <typename Intersect>
+bool BVH::traverse( const Shapes::Ray& ray, float& t_max, Intersect intersect, const unsigned root ) const
+{
+	if ( m_nodes.empty() )
+		return false;
+
+	const vec3& inv_dir = ray.inv_dir;
+
+	// pending far children with their entry time
+	unsigned	stack_node[max_depth];
+	float		stack_time[max_depth];
+	unsigned	stack_size = 0u;
+
+	float t_entry;
+	if ( m_nodes[root].bounds.intersect( ray.pos, inv_dir, t_max, t_entry ) == false )
+		return false;
+
+	bool hit = false;
+	unsigned index = root;
+
+	while ( true )
+	{
+		const Node& node = m_nodes[index];
+		count_visit();
+
+		// leaf -> test the primitives
+		if ( node.count != 0u )
+		{
+			for ( unsigned i = node.first; i < node.first + node.count; i++ )
+				hit |= intersect( m_primitives[i], t_max );
+		}
+		// interior -> visit the closest child first
+		else
+		{
+			unsigned near_child = index + 1u;
+			unsigned far_child	= node.first;
+
+			float t_near, t_far;
+			bool hit_near	= m_nodes[near_child].bounds.intersect( ray.pos, inv_dir, t_max, t_near );
+			bool hit_far	= m_nodes[far_child].bounds.intersect( ray.pos, inv_dir, t_max, t_far );
+
+			if ( hit_near && hit_far )
+			{
+				if ( t_far < t_near )
+					std::swap( near_child, far_child );
+
+				stack_node[stack_size] = far_child;
+				stack_time[stack_size] = glm::max( t_near, t_far );
+				stack_size++;
+				index = near_child;
+				continue;
+			}
+			if ( hit_near || hit_far )
+			{
+				index = hit_near ? near_child : far_child;
+				continue;
+			}
+		}
+
+		// pop the next node that is still closer than the current hit
+		bool found = false;
+		while ( stack_size > 0u && found == false )
+		{
+			stack_size--;
+			index = stack_node[stack_size];
+			found = stack_time[stack_size] <= t_max;
+		}
+
+		if ( found == false )
+			break;
+	}
+
+	return hit;
+}
+
+/**
+* @brief traverse the hierarchy with a packet of rays, sharing the node visits between them
+*
+* Nodes are tested against all the rays at once with SIMD. Once a subtree is only hit by
+* one or two rays the packet has diverged and those rays continue on their own.
+* @param packet		the rays, t_max of each lane is updated by the intersection routine
+* @param intersect	bool( unsigned lane, unsigned primitive, float& t_max ), true if the primitive was hit closer than t_max
+*/
+template <typename Intersect>
+void BVH::traverse_packet( Packets::RayPacket& packet, Intersect intersect ) const
+{
+	if ( m_nodes.empty() )
+		return;
+
+	const unsigned single_ray_threshold = Packets::width() / 4u;
+
+	// pending far children with the rays that hit them
+	unsigned stack_node[max_depth];
+	unsigned stack_mask[max_depth];
+	unsigned stack_size = 0u;
+
+	unsigned index = 0u;
+	unsigned mask = Packets::intersect_box( m_nodes[0].bounds, packet ) & packet.active_mask();
+
+	while ( true )
+	{
+		const Node& node = m_nodes[index];
+		count_visit();
+
+		// diverged -> trace the remaining rays one by one from this node
+		if ( mask != 0u && Packets::count( mask ) <= single_ray_threshold )
+		{
+			for ( unsigned lane = 0u; lane < packet.count; lane++ )
+			{
+				if ( ( mask & ( 1u << lane ) ) == 0u )
+					continue;
+
+				traverse( packet.rays[lane], packet.t_max[lane], [&]( const unsigned primitive, float& t_max )
+				{
+					return intersect( lane, primitive, t_max );
+				}, index );
+			}
+		}
+		// leaf -> test the primitives with every ray that reached it
+		else if ( mask != 0u && node.count != 0u )
+		{
+			for ( unsigned i = node.first; i < node.first + node.count; i++ )
+			{
+				for ( unsigned lane = 0u; lane < packet.count; lane++ )
+				{
+					if ( mask & ( 1u << lane ) )
+						intersect( lane, m_primitives[i], packet.t_max[lane] );
+				}
+			}
+		}
+		// interior -> visit the child closest along the packet direction first
+		else if ( mask != 0u )
+		{
+			unsigned near_child = index + 1u;
+			unsigned far_child	= node.first;
+
+			unsigned mask_near	= Packets::intersect_box( m_nodes[near_child].bounds, packet ) & mask;
+			unsigned mask_far	= Packets::intersect_box( m_nodes[far_child].bounds, packet ) & mask;
+
+			if ( dot( m_nodes[far_child].bounds.center() - m_nodes[near_child].bounds.center(), packet.direction ) < 0.0f )
+			{
+				std::swap( near_child, far_child );
+				std::swap( mask_near, mask_far );
+			}
+
+			if ( mask_near != 0u && mask_far != 0u )
+			{
+				stack_node[stack_size] = far_child;
+				stack_mask[stack_size] = mask_far;
+				stack_size++;
+			}
+
+			if ( mask_near != 0u || mask_far != 0u )
+			{
+				index = mask_near != 0u ? near_child : far_child;
+				mask = mask_near != 0u ? mask_near : mask_far;
+				continue;
+			}
+		}
+
+		// pop the next node, dropping the rays that already found something closer
+		mask = 0u;
+		while ( stack_size > 0u && mask == 0u )
+		{
+			stack_size--;
+			index = stack_node[stack_size];
+			mask = Packets::intersect_box( m_nodes[index].bounds, packet ) & stack_mask[stack_size];
+		}
+
+		if ( mask == 0u )
+			break;
+	}
+}
+
+/**
+* @brief traverse the hierarchy until any primitive blocks the ray (no ordering needed)
+* @param ray		the ray
+* @param t_max		maximum time of the blocking intersection
+* @param occluded	bool( unsigned primitive ), true if the primitive blocks the ray before t_max
+* @return true if any primitive blocks the ray
+*/
+template <typename Occluded>
+bool BVH::occluded( const Shapes::Ray& ray, const float t_max, Occluded occluded ) const
+{
+	if ( m_nodes.empty() )
+		return false;
+
+	const vec3& inv_dir = ray.inv_dir;
+
+	unsigned stack[max_depth];
+	unsigned stack_size = 0u;
+	stack[stack_size++] = 0u;
+
+	while ( stack_size > 0u )
+	{
+		const Node& node = m_nodes[stack[--stack_size]];
+		count_visit();
+
+		float t_entry;
+		if ( node.bounds.intersect( ray.pos, inv_dir, t_max, t_entry ) == false )
+			continue;
+
+		// leaf -> first blocking primitive ends the query
+		if ( node.count != 0u )
+		{
+			for ( unsigned i = node.first; i < node.first + node.count; i++ )
+				if ( occluded( m_primitives[i] ) )
+					return true;
+		}
+		// interior -> both children
+		else
+		{
+			stack[stack_size++] = node.first;
+			stack[stack_size++] = static_cast<unsigned>( &node - m_nodes.data() ) + 1u;
+		}
+	}
+
+	return false;
+}
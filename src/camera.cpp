@@ -9,6 +9,7 @@ Creation date: 01/09/2020
 ----------------------------------------------------------------------------------------------------------*/
 
 #include "camera.h"
+#include "sampling.h"
 
 /**
 * @brief camera constructor
@@ -25,15 +26,19 @@ Camera::Camera( const vec3 & center, const vec3 & u, const vec3 & v, const float
 
 /**
 * @brief get a random offset in the lens using Alvaro's method
+* @param sampler	values of the camera sample
 * @return random offset
 */
-vec2 Camera::get_rand_lense_point() const
+vec2 Camera::get_rand_lense_point( Sampler& sampler ) const
 {
+	// triangle and point in it
+	const unsigned dimension = sampler.next_dimension( 2u );
+
 	// lense has defined shape
 	if ( lense_triangles.empty() == false )
 	{
 		// area euristic [0,1]
-		float area = rand() / static_cast<float>( RAND_MAX );
+		float area = sampler.get_1d( dimension );
 
 		float total_area = 0.0f;
 
@@ -42,14 +47,12 @@ vec2 Camera::get_rand_lense_point() const
 		{
 			total_area += triangle.area_euristic;
 			if ( total_area >= area )
-				return triangle.get_rand_point();
+				return triangle.get_rand_point( sampler.get_2d( dimension + 1u ) );
 		}
 	}
 
 	// lense has no shape
 
 	// random point in a circular lense
-	float r_angle = rand() / static_cast< float >( RAND_MAX ) * 2 * glm::pi<float>();
-	float r_radius = aperture * sqrt( rand() / static_cast< float >( RAND_MAX ) );
-	return { r_radius * cos( r_angle ), r_radius * sin( r_angle ) };
+	return Sampling::concentric_disk( sampler.get_2d( dimension + 1u ) ) * aperture;
 }
@@ -12,6 +12,7 @@ Creation date: 01/09/2020
 
 #include "math_utils.h"
 #include "shapes.h"
+#include "sampler.h"
 
 #include <vector>
 
@@ -34,7 +35,7 @@ struct Camera
 
 	Camera() = default;
 	Camera( const vec3& center, const vec3& u, const vec3& v, const float r );
-	vec2 get_rand_lense_point() const;
+	vec2 get_rand_lense_point( Sampler& sampler ) const;
 
 
 };
\ No newline at end of file
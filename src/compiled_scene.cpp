@@ -0,0 +1,789 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: compiled_scene.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "compiled_scene.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	/**
+	* @brief slab test returning the face the ray hits
+	* @param ray_pos	start point of the ray
+	* @param inv_dir	inverse of the ray direction
+	* @param min		minimum corner of the box
+	* @param max		maximum corner of the box
+	* @param face		face hit (return), axis * 2 for the min side and axis * 2 + 1 for the max side
+	* @return time of the intersection (exit time if the ray starts inside), -1 if there is none
+	*/
+	float slab_hit( const vec3& ray_pos, const vec3& inv_dir, const vec3& min, const vec3& max, unsigned& face )
+	{
+		float t_min = 0.0f;
+		float t_max = std::numeric_limits<float>::max();
+
+		unsigned face_min = 0u;
+		unsigned face_max = 0u;
+
+		for ( unsigned axis = 0u; axis < 3u; axis++ )
+		{
+			float t0 = ( min[axis] - ray_pos[axis] ) * inv_dir[axis];
+			float t1 = ( max[axis] - ray_pos[axis] ) * inv_dir[axis];
+			unsigned face0 = axis * 2u;
+			unsigned face1 = axis * 2u + 1u;
+
+			if ( t0 > t1 )
+			{
+				std::swap( t0, t1 );
+				std::swap( face0, face1 );
+			}
+
+			// NaN (ray inside the plane of a slab) fails both comparisons and keeps the interval
+			if ( t0 > t_min )
+			{
+				t_min = t0;
+				face_min = face0;
+			}
+			if ( t1 < t_max )
+			{
+				t_max = t1;
+				face_max = face1;
+			}
+		}
+
+		if ( t_max < t_min )
+			return -1.0f;
+
+		// the ray starts inside -> leaving face
+		if ( t_min == 0.0f )
+		{
+			face = face_max;
+			return t_max;
+		}
+
+		face = face_min;
+		return t_min;
+	}
+
+	/**
+	* @brief grazing limit of the triangle test for a ray in the frame of a mesh instance
+	*
+	* The direction is scaled by the instance, the determinant grows with its length.
+	* @param local_ray	ray moved to the frame of the geometry
+	* @return limit of the cosine between the ray and the plane, times the length of the direction
+	*/
+	float grazing_limit( const Shapes::Ray& local_ray )
+	{
+		return 0.01f * length( local_ray.dir );
+	}
+}
+
+/**
+* @brief compile constructor
+* @param scene	scene to compile
+*/
+CompiledScene::CompiledScene( const Scene& scene )
+{
+	compile( scene );
+}
+
+/**
+* @brief copy the shapes of a scene into the flat arrays and build the hierarchy over them
+* @param scene	scene to compile
+*/
+void CompiledScene::compile( const Scene& scene )
+{
+	clear();
+
+	m_camera	= scene.camera();
+	m_lights	= scene.lights();
+	m_ambient	= scene.ambient();
+	m_air		= scene.air();
+	m_use_bvh	= scene.use_bvh();
+
+	m_primitives.reserve( scene.shapes().size() );
+	m_materials.reserve( scene.shapes().size() );
+
+	// bounds of the compiled shapes for the top level hierarchy
+	std::vector<Shapes::AABB> bounds;
+	bounds.reserve( scene.shapes().size() );
+
+	// geometry already compiled for another instance
+	std::unordered_map<const Shapes::MeshData*, unsigned> geometries;
+
+	for ( const auto shape : scene.shapes() )
+	{
+		if ( add_shape( *shape, geometries ) )
+			bounds.push_back( shape->bounds() );
+	}
+
+	if ( m_use_bvh )
+		m_bvh.build( bounds );
+}
+
+/**
+* @brief remove all the compiled data
+*/
+void CompiledScene::clear()
+{
+	m_primitives.clear();
+	m_materials.clear();
+
+	m_spheres		= Spheres();
+	m_boxes			= Boxes();
+	m_oriented_boxes	= OrientedBoxes();
+	m_polygons		= Polygons();
+	m_ellipsoids	= Ellipsoids();
+	m_meshes		= Meshes();
+	m_geometries	= Geometries();
+	m_triangles		= Shapes::TriangleData();
+
+	m_bvh.clear();
+	m_use_bvh = true;
+	m_lights.clear();
+}
+
+/**
+* @brief append a shape to the arrays of its type
+* @param shape
+* @param geometries		index of the compiled geometry of each mesh data (updated)
+* @return false if the type of the shape is unknown
+*/
+bool CompiledScene::add_shape( const Shapes::Shape& shape, std::unordered_map<const Shapes::MeshData*, unsigned>& geometries )
+{
+	Primitive primitive;
+	const unsigned material = static_cast<unsigned>( m_materials.size() );
+
+	if ( auto sphere = dynamic_cast<const Shapes::Sphere*>( &shape ) )
+	{
+		primitive = { PrimitiveType::sphere, static_cast<unsigned>( m_spheres.radius.size() ) };
+
+		m_spheres.x.push_back( sphere->pos.x );
+		m_spheres.y.push_back( sphere->pos.y );
+		m_spheres.z.push_back( sphere->pos.z );
+		m_spheres.radius.push_back( sphere->radius );
+		m_spheres.material.push_back( material );
+	}
+	else if ( auto box = dynamic_cast<const Shapes::Box*>( &shape ) )
+	{
+		if ( box->is_axis_aligned() )
+		{
+			primitive = { PrimitiveType::box, static_cast<unsigned>( m_boxes.material.size() ) };
+
+			const Shapes::AABB bounds = box->bounds();
+			m_boxes.min.push_back( bounds.min );
+			m_boxes.max.push_back( bounds.max );
+			m_boxes.material.push_back( material );
+		}
+		else
+		{
+			primitive = { PrimitiveType::oriented_box, static_cast<unsigned>( m_oriented_boxes.material.size() ) };
+
+			// the edges map to the axes of the unit cube
+			const mat3 inv_model = inverse( mat3( box->length, box->width, box->height ) );
+			const mat3 normal_matrix = transpose( inv_model );
+
+			m_oriented_boxes.pos.push_back( box->pos );
+			m_oriented_boxes.inv_model.push_back( inv_model );
+			for ( int axis = 0; axis < 3; axis++ )
+				m_oriented_boxes.normals.push_back( normalize( normal_matrix[axis] ) );
+			m_oriented_boxes.material.push_back( material );
+		}
+	}
+	else if ( auto polygon = dynamic_cast<const Shapes::Polygon*>( &shape ) )
+	{
+		primitive = { PrimitiveType::polygon, static_cast<unsigned>( m_polygons.material.size() ) };
+
+		// triangle fan around the first vertex
+		const unsigned first = static_cast<unsigned>( m_triangles.origin.size() );
+		for ( unsigned i = 1u; i + 1u < polygon->vertices.size(); i++ )
+			add_triangle( polygon->vertices[0u], polygon->vertices[i], polygon->vertices[i + 1u] );
+
+		m_polygons.first_triangle.push_back( first );
+		m_polygons.triangle_count.push_back( static_cast<unsigned>( m_triangles.origin.size() ) - first );
+		m_polygons.normal.push_back( polygon->normal );
+		m_polygons.material.push_back( material );
+	}
+	else if ( auto ellipsoid = dynamic_cast<const Shapes::Ellipsoid*>( &shape ) )
+	{
+		primitive = { PrimitiveType::ellipsoid, static_cast<unsigned>( m_ellipsoids.material.size() ) };
+
+		m_ellipsoids.pos.push_back( ellipsoid->pos );
+		m_ellipsoids.inv_model.push_back( ellipsoid->inv_model );
+		m_ellipsoids.material.push_back( material );
+	}
+	else if ( auto mesh = dynamic_cast<const Shapes::Mesh*>( &shape ) )
+	{
+		primitive = { PrimitiveType::mesh, static_cast<unsigned>( m_meshes.material.size() ) };
+
+		// the triangles are only copied for the first instance of a geometry
+		auto found = geometries.find( mesh->data.get() );
+		if ( found == geometries.end() )
+			found = geometries.emplace( mesh->data.get(), add_geometry( *mesh->data ) ).first;
+
+		m_meshes.geometry.push_back( found->second );
+		m_meshes.pos.push_back( vec3( mesh->model[3] ) );
+		m_meshes.inv_model.push_back( inverse( mat3( mesh->model ) ) );
+		m_meshes.material.push_back( material );
+	}
+	else
+		return false;
+
+	m_primitives.push_back( primitive );
+	m_materials.push_back( shape.material );
+	return true;
+}
+
+/**
+* @brief append the triangles and hierarchy of a mesh geometry
+* @param data	geometry in its own frame
+* @return index of the geometry
+*/
+unsigned CompiledScene::add_geometry( const Shapes::MeshData& data )
+{
+	const Shapes::TriangleData& triangles = data.triangles;
+	m_geometries.first_triangle.push_back( static_cast<unsigned>( m_triangles.origin.size() ) );
+	m_geometries.bvh.push_back( data.bvh );
+
+	m_triangles.origin.insert( m_triangles.origin.end(), triangles.origin.begin(), triangles.origin.end() );
+	m_triangles.edge1.insert( m_triangles.edge1.end(), triangles.edge1.begin(), triangles.edge1.end() );
+	m_triangles.edge2.insert( m_triangles.edge2.end(), triangles.edge2.begin(), triangles.edge2.end() );
+	m_triangles.normal.insert( m_triangles.normal.end(), triangles.normal.begin(), triangles.normal.end() );
+	m_triangles.normal_length.insert( m_triangles.normal_length.end(), triangles.normal_length.begin(), triangles.normal_length.end() );
+
+	return static_cast<unsigned>( m_geometries.bvh.size() ) - 1u;
+}
+
+/**
+* @brief store the edges and normal of a triangle in the shared triangle arrays
+* @param a		first vertex
+* @param b		second vertex
+* @param c		third vertex
+*/
+void CompiledScene::add_triangle( const vec3& a, const vec3& b, const vec3& c )
+{
+	vec3 normal = cross( b - a, c - a );
+	float normal_length = length( normal );
+
+	m_triangles.origin.push_back( a );
+	m_triangles.edge1.push_back( b - a );
+	m_triangles.edge2.push_back( c - a );
+	m_triangles.normal_length.push_back( normal_length );
+	m_triangles.normal.push_back( normal_length > 0.0f ? normal / normal_length : vec3( 0.0f ) );
+}
+
+/**
+* @brief compute the closest intersection of a ray with the scene
+* @param ray
+* @param hit	closest hit (return)
+* @return true if the ray hits anything
+*/
+bool CompiledScene::intersect( const Shapes::Ray& ray, Intersection::Hit& hit ) const
+{
+	float closest = std::numeric_limits<float>::max();
+
+	// traverse the hierarchy keeping the closest hit
+	if ( m_use_bvh )
+	{
+		return m_bvh.traverse( ray, closest, [&]( const unsigned primitive, float& t_max )
+		{
+			if ( intersect_primitive( primitive, ray, t_max, hit ) == false )
+				return false;
+
+			t_max = hit.time;
+			return true;
+		} );
+	}
+
+	// test every primitive
+	bool result = false;
+	for ( unsigned i = 0u; i < m_primitives.size(); i++ )
+	{
+		if ( intersect_primitive( i, ray, closest, hit ) )
+		{
+			closest = hit.time;
+			result = true;
+		}
+	}
+
+	return result;
+}
+
+/**
+* @brief compute the closest intersection of a packet of rays with the scene
+* @param packet		rays to trace
+* @param hits		closest hit of each ray in the packet, time -1 if there is none (return)
+*/
+void CompiledScene::intersect_packet( Packets::RayPacket& packet, Intersection::Hit* hits ) const
+{
+	// without hierarchy there are no node visits to share
+	if ( m_use_bvh == false )
+	{
+		for ( unsigned i = 0u; i < packet.count; i++ )
+			intersect( packet.rays[i], hits[i] );
+		return;
+	}
+
+	m_bvh.traverse_packet( packet, [&]( const unsigned lane, const unsigned primitive, float& t_max )
+	{
+		if ( intersect_primitive( primitive, packet.rays[lane], t_max, hits[lane] ) == false )
+			return false;
+
+		t_max = hits[lane].time;
+		return true;
+	} );
+}
+
+/**
+* @brief check if any primitive blocks the ray before a given time
+* @param ray
+* @param t_max	maximum time of the blocking contact
+* @return true if the ray is blocked
+*/
+bool CompiledScene::occluded( const Shapes::Ray& ray, const float t_max ) const
+{
+	// stop at the first primitive found in the hierarchy
+	if ( m_use_bvh )
+	{
+		return m_bvh.occluded( ray, t_max, [&]( const unsigned primitive )
+		{
+			return occluded_primitive( primitive, ray, t_max );
+		} );
+	}
+
+	for ( unsigned i = 0u; i < m_primitives.size(); i++ )
+	{
+		if ( occluded_primitive( i, ray, t_max ) )
+			return true;
+	}
+
+	return false;
+}
+
+/**
+* @brief compute the shading information of a hit, only done for the closest one
+* @param ray	ray that produced the hit
+* @param hit	closest hit of the ray
+* @return contact information of the intersection
+*/
+Intersection::Contact CompiledScene::contact( const Shapes::Ray& ray, const Intersection::Hit& hit ) const
+{
+	const unsigned i = m_primitives[hit.primitive].index;
+	const vec3 point = ray.pos + hit.time * ray.dir;
+
+	switch ( m_primitives[hit.primitive].type )
+	{
+	case PrimitiveType::sphere:
+	{
+		vec3 normal = normalize( point - vec3( m_spheres.x[i], m_spheres.y[i], m_spheres.z[i] ) );
+		return Intersection::Contact( hit.time, point, normal, m_materials[m_spheres.material[i]] );
+	}
+	case PrimitiveType::box:
+	{
+		vec3 normal( 0.0f );
+		normal[hit.element / 2u] = hit.element % 2u == 0u ? -1.0f : 1.0f;
+		return Intersection::Contact( hit.time, point, normal, m_materials[m_boxes.material[i]] );
+	}
+	case PrimitiveType::oriented_box:
+	{
+		vec3 normal = m_oriented_boxes.normals[i * 3u + hit.element / 2u];
+		normal *= hit.element % 2u == 0u ? -1.0f : 1.0f;
+		return Intersection::Contact( hit.time, point, normal, m_materials[m_oriented_boxes.material[i]] );
+	}
+	case PrimitiveType::polygon:
+		return Intersection::Contact( hit.time, point, m_polygons.normal[i], m_materials[m_polygons.material[i]] );
+	case PrimitiveType::ellipsoid:
+	{
+		const mat3& inv_model = m_ellipsoids.inv_model[i];
+		vec3 point_unit = inv_model * ( point - m_ellipsoids.pos[i] );
+		vec3 normal = normalize( transpose( inv_model ) * point_unit );
+		return Intersection::Contact( hit.time, point, normal, m_materials[m_ellipsoids.material[i]] );
+	}
+	case PrimitiveType::mesh:
+	{
+		// normal of the geometry back to the world
+		vec3 normal = normalize( transpose( m_meshes.inv_model[i] ) * m_triangles.normal[hit.element] );
+		return Intersection::Contact( hit.time, point, normal, m_materials[m_meshes.material[i]] );
+	}
+	}
+
+	return Intersection::Contact();
+}
+
+/**
+* @brief compute the intersection between a ray and a primitive
+* @param primitive	index of the primitive
+* @param ray
+* @param t_max		only hits closer than this are reported
+* @param hit		hit information (return, untouched if there is no hit)
+* @return true if the primitive is hit in [0, t_max)
+*/
+bool CompiledScene::intersect_primitive( const unsigned primitive, const Shapes::Ray& ray, const float t_max, Intersection::Hit& hit ) const
+{
+	const unsigned i = m_primitives[primitive].index;
+
+	float		time = -1.0f;
+	unsigned	element = 0u;
+	vec2		barycentric( 0.0f );
+
+	switch ( m_primitives[primitive].type )
+	{
+	case PrimitiveType::sphere:
+		time = hit_sphere( i, ray );
+		break;
+	case PrimitiveType::box:
+		time = hit_box( i, ray, element );
+		break;
+	case PrimitiveType::oriented_box:
+		time = hit_oriented_box( i, ray, element );
+		break;
+	case PrimitiveType::polygon:
+		time = hit_polygon( i, ray, element, barycentric );
+		break;
+	case PrimitiveType::ellipsoid:
+		time = hit_ellipsoid( i, ray );
+		break;
+	case PrimitiveType::mesh:
+	{
+		// the triangles farther than the current closest hit are culled by the mesh hierarchy
+		float closest = t_max;
+		if ( hit_mesh( i, ray, closest, element, barycentric ) )
+			time = closest;
+		break;
+	}
+	}
+
+	if ( time == -1.0f || time >= t_max )
+		return false;
+
+	hit.time		= time;
+	hit.primitive	= primitive;
+	hit.element		= element;
+	hit.barycentric	= barycentric;
+	return true;
+}
+
+/**
+* @brief check if a primitive blocks the ray before a given time
+* @param primitive	index of the primitive
+* @param ray
+* @param t_max		maximum time
+* @return true if there is an intersection in [0, t_max)
+*/
+bool CompiledScene::occluded_primitive( const unsigned primitive, const Shapes::Ray& ray, const float t_max ) const
+{
+	// any triangle closer than t_max is enough
+	if ( m_primitives[primitive].type == PrimitiveType::mesh )
+	{
+		const unsigned i = m_primitives[primitive].index;
+		const unsigned geometry = m_meshes.geometry[i];
+		const unsigned first = m_geometries.first_triangle[geometry];
+		const Shapes::Ray local = mesh_ray( i, ray );
+		const float grazing = grazing_limit( local );
+
+		return m_geometries.bvh[geometry].occluded( local, t_max, [&]( const unsigned triangle )
+		{
+			float time;
+			vec2 barycentric;
+			return hit_triangle( first + triangle, local, t_max, time, barycentric, grazing ) && time < t_max;
+		} );
+	}
+
+	Intersection::Hit hit;
+	return intersect_primitive( primitive, ray, t_max, hit );
+}
+
+/**
+* @brief compute the first time the ray hits a sphere
+* @param i		index of the sphere
+* @param ray	the ray
+* @return time of the intersection, -1 if there is none
+*/
+float CompiledScene::hit_sphere( const unsigned i, const Shapes::Ray& ray ) const
+{
+	vec3 v = ray.pos - vec3( m_spheres.x[i], m_spheres.y[i], m_spheres.z[i] );
+	float radius = m_spheres.radius[i];
+
+	float a = dot( ray.dir, ray.dir );
+	float b = 2.0f * dot( ray.dir, v );
+	float c = dot( v, v ) - radius * radius;
+
+	float disc = b * b - 4.0f * a * c;
+
+	if ( disc < 0.0f )
+		return -1.0f;
+
+	// compute the time values for the intersection
+	float t1 = ( -b + sqrt( disc ) ) / ( 2 * a );
+	float t2 = ( -b - sqrt( disc ) ) / ( 2 * a );
+
+	// the sphere is behind
+	if ( t1 < 0.0f )
+		return -1.0f;
+	// the ray starts inside
+	else if ( t2 < 0.0f )
+		return t1;
+	// the sphere is in front
+	else
+		return t2;
+}
+
+/**
+* @brief compute the time at which the ray hits an axis aligned box
+* @param i		index of the box
+* @param ray	the ray
+* @param face	face that was hit (return), axis * 2 for the min side and axis * 2 + 1 for the max side
+* @return time of the intersection, -1 if there is none
+*/
+float CompiledScene::hit_box( const unsigned i, const Shapes::Ray& ray, unsigned& face ) const
+{
+	return slab_hit( ray.pos, ray.inv_dir, m_boxes.min[i], m_boxes.max[i], face );
+}
+
+/**
+* @brief compute the time at which the ray hits an oriented box
+* @param i		index of the box
+* @param ray	the ray
+* @param face	face that was hit (return), axis * 2 for the min side and axis * 2 + 1 for the max side
+* @return time of the intersection, -1 if there is none
+*/
+float CompiledScene::hit_oriented_box( const unsigned i, const Shapes::Ray& ray, unsigned& face ) const
+{
+	const mat3& inv_model = m_oriented_boxes.inv_model[i];
+
+	// the transformation is affine so the time is the same in the frame of the box
+	const vec3 ray_pos = inv_model * ( ray.pos - m_oriented_boxes.pos[i] );
+	const vec3 ray_dir = inv_model * ray.dir;
+
+	return slab_hit( ray_pos, 1.0f / ray_dir, vec3( 0.0f ), vec3( 1.0f ), face );
+}
+
+/**
+* @brief compute the time at which the ray hits a polygon
+* @param i				index of the polygon
+* @param ray			the ray
+* @param triangle		fan triangle hit (return)
+* @param barycentric	coordinates of the hit in the triangle (return)
+* @return time of the intersection with the first fan triangle hit, -1 if there is none
+*/
+float CompiledScene::hit_polygon( const unsigned i, const Shapes::Ray& ray, unsigned& triangle, vec2& barycentric ) const
+{
+	const unsigned first = m_polygons.first_triangle[i];
+	const unsigned last = first + m_polygons.triangle_count[i];
+
+	for ( triangle = first; triangle < last; triangle++ )
+	{
+		float time;
+		if ( hit_triangle( triangle, ray, std::numeric_limits<float>::max(), time, barycentric ) )
+			return time;
+	}
+
+	return -1.0f;
+}
+
+/**
+* @brief compute the first time the ray hits an ellipsoid
+* @param i		index of the ellipsoid
+* @param ray	the ray
+* @return time of the intersection, -1 if there is none
+*/
+float CompiledScene::hit_ellipsoid( const unsigned i, const Shapes::Ray& ray ) const
+{
+	const mat3& inv_model = m_ellipsoids.inv_model[i];
+
+	vec3 p0 = inv_model * ( ray.pos - m_ellipsoids.pos[i] );
+	vec3 ray_dir = inv_model * ray.dir;
+
+	float a = dot( ray_dir, ray_dir );
+	float b = 2.0f * dot( p0, ray_dir );
+	float c = dot( p0, p0 ) - 1.0f;
+
+	float disc = b * b - 4.0f * a * c;
+
+	if ( disc < 0.0f )
+		return -1.0f;
+
+	// compute the time values for the intersection
+	float t1 = ( -b + sqrt( disc ) ) / ( 2.0f * a );
+	float t2 = ( -b - sqrt( disc ) ) / ( 2.0f * a );
+
+	// the ellipsoid is behind
+	if ( t1 < 0.0f )
+		return -1.0f;
+	// the ray starts inside
+	else if ( t2 < 0.0f )
+		return t1;
+	// the ellipsoid is in front
+	else
+		return t2;
+}
+
+/**
+* @brief move a ray to the frame of the geometry of a mesh instance
+*
+* The direction is not normalized, the transformation is affine so the times along the
+* ray are the same in both frames and the hits can be compared with the rest of the scene.
+* @param i		index of the mesh
+* @param ray	ray in the world
+* @return ray in the frame of the geometry
+*/
+Shapes::Ray CompiledScene::mesh_ray( const unsigned i, const Shapes::Ray& ray ) const
+{
+	const mat3& inv_model = m_meshes.inv_model[i];
+	return Shapes::Ray( inv_model * ( ray.pos - m_meshes.pos[i] ), inv_model * ray.dir );
+}
+
+/**
+* @brief compute the closest triangle of a mesh hit by the ray
+* @param i				index of the mesh
+* @param ray			the ray
+* @param t_max			maximum time accepted, time of the hit (return)
+* @param triangle		index of the triangle hit in the shared triangle arrays (return)
+* @param barycentric	coordinates of the hit in the triangle (return)
+* @return true if any triangle was hit
+*/
+bool CompiledScene::hit_mesh( const unsigned i, const Shapes::Ray& ray, float& t_max, unsigned& triangle, vec2& barycentric ) const
+{
+	const unsigned geometry = m_meshes.geometry[i];
+	const unsigned first = m_geometries.first_triangle[geometry];
+	const Shapes::Ray local_ray = mesh_ray( i, ray );
+	const float grazing = grazing_limit( local_ray );
+	unsigned triangle_hit = 0u;
+
+	// the root of the bottom level hierarchy already culls against the bounding volume
+	bool hit = m_geometries.bvh[geometry].traverse( local_ray, t_max, [&]( const unsigned local, float& closest )
+	{
+		float time_curr;
+		vec2 barycentric_curr;
+		if ( hit_triangle( first + local, local_ray, closest, time_curr, barycentric_curr, grazing ) == false )
+			return false;
+
+		// ties (shared edges) go to the first triangle in the mesh
+		if ( time_curr == closest && local > triangle_hit )
+			return false;
+
+		closest = time_curr;
+		triangle_hit = local;
+		barycentric = barycentric_curr;
+		return true;
+	} );
+
+	triangle = first + triangle_hit;
+	return hit;
+}
+
+/**
+* @brief intersect a ray with one of the triangles
+* @param i				index of the triangle
+* @param ray			the ray
+* @param t_max			maximum time accepted (included)
+* @param time			time of the intersection (return)
+* @param barycentric	weights of the second and third vertices at the hit (return)
+* @param grazing		cosine between the ray and the plane below which it is parallel, times the length of the direction
+* @return true if the triangle is hit in [0, t_max]
+*/
+bool CompiledScene::hit_triangle( const unsigned i, const Shapes::Ray& ray, const float t_max, float& time, vec2& barycentric, const float grazing ) const
+{
+	const vec3& edge1 = m_triangles.edge1[i];
+	const vec3& edge2 = m_triangles.edge2[i];
+
+	// Moller-Trumbore with every comparison scaled by the determinant
+	const vec3 p = cross( ray.dir, edge2 );
+	const float det = dot( edge1, p );
+
+	// parallel ray or degenerate triangle (cosine between the ray and the plane below 0.01)
+	if ( glm::abs( det ) <= grazing * m_triangles.normal_length[i] )
+		return false;
+
+	const float sign = det < 0.0f ? -1.0f : 1.0f;
+	const float abs_det = det * sign;
+
+	const vec3 s = ray.pos - m_triangles.origin[i];
+	const float u = dot( s, p ) * sign;
+	if ( u < 0.0f || u > abs_det )
+		return false;
+
+	const vec3 q = cross( s, edge1 );
+	const float v = dot( ray.dir, q ) * sign;
+	if ( v < 0.0f || u + v > abs_det )
+		return false;
+
+	const float t = dot( edge2, q ) * sign;
+	if ( t < 0.0f || t > t_max * abs_det )
+		return false;
+
+	// divisions only once the triangle is known to be hit
+	time = t / abs_det;
+	barycentric = vec2( u, v ) / abs_det;
+	return time <= t_max;
+}
+
+/**
+* @brief get the camera
+* @return camera
+*/
+const Camera& CompiledScene::camera() const
+{
+	return m_camera;
+}
+
+/**
+* @brief get the point lights
+* @return lights
+*/
+const std::vector<Lights::Point>& CompiledScene::lights() const
+{
+	return m_lights;
+}
+
+/**
+* @brief get the ambient light
+* @return ambient
+*/
+const Lights::Ambient& CompiledScene::ambient() const
+{
+	return m_ambient;
+}
+
+/**
+* @brief get the air properties
+* @return air
+*/
+const Lights::Air& CompiledScene::air() const
+{
+	return m_air;
+}
+
+/**
+* @brief get the materials referenced by the primitives
+* @return materials
+*/
+const std::vector<Material>& CompiledScene::materials() const
+{
+	return m_materials;
+}
+
+/**
+* @brief get the primitives, in the same order as the shapes of the scene
+* @return primitives
+*/
+const std::vector<CompiledScene::Primitive>& CompiledScene::primitives() const
+{
+	return m_primitives;
+}
+
+/**
+* @brief check if the scene is traversed using the bvh
+* @return true if the bvh is used
+*/
+bool CompiledScene::use_bvh() const
+{
+	return m_use_bvh;
+}
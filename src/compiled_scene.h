@@ -0,0 +1,154 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: compiled_scene.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "scene.h"
+#include "bvh.h"
+#include "packet.h"
+#include "intersection.h"
+#include "math_utils.h"
+#include <unordered_map>
+#include <vector>
+
+/**
+* @brief render ready copy of a scene
+*
+* The shapes are split by type into contiguous arrays (structure of arrays for the
+* fields the kernels read) and reference their material by index, so the traversal
+* walks plain data instead of calling virtual functions on objects spread in memory.
+*/
+class CompiledScene
+{
+	friend class SceneCache;	// stores the arrays as they are
+
+public:
+
+	enum class PrimitiveType : unsigned { sphere, box, oriented_box, polygon, ellipsoid, mesh };
+
+	// entry referenced by the leaves of the top level hierarchy
+	struct Primitive
+	{
+		PrimitiveType	type;
+		unsigned		index;		// entry in the arrays of its type
+	};
+
+	struct Spheres
+	{
+		std::vector<float>		x, y, z;
+		std::vector<float>		radius;
+		std::vector<unsigned>	material;
+	};
+
+	// boxes with their edges along the world axes
+	struct Boxes
+	{
+		std::vector<vec3>		min, max;
+		std::vector<unsigned>	material;
+	};
+
+	// any other box, intersected as the unit cube in its own frame
+	struct OrientedBoxes
+	{
+		std::vector<vec3>		pos;
+		std::vector<mat3>		inv_model;	// world to box frame
+		std::vector<vec3>		normals;	// three per box, outward normal of the far face of each axis
+		std::vector<unsigned>	material;
+	};
+
+	struct Polygons
+	{
+		std::vector<unsigned>	first_triangle;	// fan triangles in the shared triangle arrays
+		std::vector<unsigned>	triangle_count;
+		std::vector<vec3>		normal;
+		std::vector<unsigned>	material;
+	};
+
+	struct Ellipsoids
+	{
+		std::vector<vec3>		pos;
+		std::vector<mat3>		inv_model;
+		std::vector<unsigned>	material;
+	};
+
+	// instances of the meshes, rays are moved to the frame of the geometry
+	struct Meshes
+	{
+		std::vector<unsigned>	geometry;		// entry in the unique geometries
+		std::vector<vec3>		pos;			// translation of the instance
+		std::vector<mat3>		inv_model;		// world to object, without the translation
+		std::vector<unsigned>	material;
+	};
+
+	// triangles of every obj file, stored once however many instances use them
+	struct Geometries
+	{
+		std::vector<unsigned>	first_triangle;	// triangles in the shared triangle arrays
+		std::vector<BVH>		bvh;			// bottom level hierarchy over the triangles (local indices)
+	};
+
+	CompiledScene() = default;
+	CompiledScene( const Scene& scene );
+	void compile( const Scene& scene );
+	void clear();
+
+	bool					intersect			( const Shapes::Ray& ray, Intersection::Hit& hit ) const;
+	void					intersect_packet	( Packets::RayPacket& packet, Intersection::Hit* hits ) const;
+	bool					occluded			( const Shapes::Ray& ray, const float t_max ) const;
+	Intersection::Contact	contact				( const Shapes::Ray& ray, const Intersection::Hit& hit ) const;
+
+private:
+
+	bool		add_shape			( const Shapes::Shape& shape, std::unordered_map<const Shapes::MeshData*, unsigned>& geometries );
+	unsigned	add_geometry		( const Shapes::MeshData& data );
+	void		add_triangle		( const vec3& a, const vec3& b, const vec3& c );
+
+	bool		intersect_primitive	( const unsigned primitive, const Shapes::Ray& ray, const float t_max, Intersection::Hit& hit ) const;
+	bool		occluded_primitive	( const unsigned primitive, const Shapes::Ray& ray, const float t_max ) const;
+
+	float		hit_sphere			( const unsigned i, const Shapes::Ray& ray ) const;
+	float		hit_box				( const unsigned i, const Shapes::Ray& ray, unsigned& face ) const;
+	float		hit_oriented_box	( const unsigned i, const Shapes::Ray& ray, unsigned& face ) const;
+	float		hit_polygon			( const unsigned i, const Shapes::Ray& ray, unsigned& triangle, vec2& barycentric ) const;
+	float		hit_ellipsoid		( const unsigned i, const Shapes::Ray& ray ) const;
+	Shapes::Ray	mesh_ray			( const unsigned i, const Shapes::Ray& ray ) const;
+	bool		hit_mesh			( const unsigned i, const Shapes::Ray& ray, float& t_max, unsigned& triangle, vec2& barycentric ) const;
+	bool		hit_triangle		( const unsigned i, const Shapes::Ray& ray, const float t_max, float& time, vec2& barycentric, const float grazing = 0.01f ) const;
+
+public:
+	const Camera&						camera		() const;
+	const std::vector<Lights::Point>&	lights		() const;
+	const Lights::Ambient&				ambient		() const;
+	const Lights::Air&					air			() const;
+	const std::vector<Material>&		materials	() const;
+	const std::vector<Primitive>&		primitives	() const;
+	bool								use_bvh		() const;
+
+private:
+	std::vector<Primitive>		m_primitives;
+	std::vector<Material>		m_materials;
+
+	Spheres						m_spheres;
+	Boxes						m_boxes;
+	OrientedBoxes				m_oriented_boxes;
+	Polygons					m_polygons;
+	Ellipsoids					m_ellipsoids;
+	Meshes						m_meshes;
+	Geometries					m_geometries;
+	Shapes::TriangleData		m_triangles;	// polygon fans and mesh triangles
+
+	BVH							m_bvh;			// top level, over m_primitives (mesh instances included)
+	bool						m_use_bvh = true;
+
+	std::vector<Lights::Point>	m_lights;
+	Lights::Ambient				m_ambient;
+	Lights::Air					m_air;
+	Camera						m_camera;
+};
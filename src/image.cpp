@@ -11,26 +11,38 @@ Creation date: 01/13/2020
 #include "image.h"
 
 #define STB_IMAGE_IMPLEMENTATION
-#include "image\stb_image.h"
+#include "image/stb_image.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "image\stb_image_write.h"
+#include "image/stb_image_write.h"
 
+#include <cstdio>
 #include <iostream>
+#include <string>
 
 namespace Image
 {
 	/**
 	* @brief save the color buffer into an image file
+	*
+	* The image is written aside and renamed, so the file is always a complete image even if
+	* the program is stopped while it is being rewritten (progressive renders).
 	* @param filepath	path to the output file
 	* @param width		width of the image
 	* @param height		height of the image
 	* @param data		color data
 	*/
-	void save_image( const char* filepath, const int width, const int height, std::vector<unsigned char>& data )
+	void save_image( const char* filepath, const int width, const int height, const std::vector<unsigned char>& data )
 	{
-		std::vector<char> img_data;
+		const std::string temporary = std::string( filepath ) + ".tmp";
 
 		// write into the file
-		stbi_write_png( filepath, width, height, 3, static_cast<void*>( &data[0] ), width * 3 );
+		if ( stbi_write_png( temporary.c_str(), width, height, 3, static_cast<const void*>( data.data() ), width * 3 ) == 0 )
+		{
+			std::cout << "Unable to write the image " << filepath << std::endl;
+			return;
+		}
+
+		std::remove( filepath );
+		std::rename( temporary.c_str(), filepath );
 	}
 }
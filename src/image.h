@@ -15,5 +15,5 @@ Creation date: 01/13/2020
 
 namespace Image
 {
-	void save_image( const char* filepath, const int width, const int height, std::vector<unsigned char>& data );
+	void save_image( const char* filepath, const int width, const int height, const std::vector<unsigned char>& data );
 }
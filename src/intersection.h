@@ -15,6 +15,16 @@ Creation date: 01/07/2020
 
 namespace Intersection
 {
+	// candidate found while traversing, the contact is only computed for the closest one
+	struct Hit
+	{
+		float		time;
+		unsigned	primitive;		// index of the primitive in the compiled scene
+		unsigned	element;		// box face or triangle of the primitive
+		vec2		barycentric;	// weights of the second and third triangle vertices
+
+		Hit() { time = -1.0f; }
+	};
 
 	struct Contact
 	{
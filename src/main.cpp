@@ -11,113 +11,200 @@ Creation date: 01/07/2020
 #include "scene.h"
 #include "raytracer.h"
 #include "image.h"
+#include "scene_cache.h"
+
+#ifdef CS500_PREVIEW
+#include "window.h"
+#endif
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <chrono>
+#include <cstdlib>
 
-Configuration read_config( std::string& in_scene, std::string& out_scene );
+Configuration read_config( const char* config_file, std::string& in_scene, std::string& out_scene );
 float read_val( std::string& data );
+std::string read_word( std::string& data );
+bool read_duration( const char* text, float& seconds );
+bool load_scene( const std::string& in_scene, const Configuration& config, CompiledScene& compiled_scene );
 
 /**
 * @brief read config file
+* @param config_file	path of the config file
 * @return in_scene		file path of input scene
 * @return out_scene		file path of output scene
 * @return configuration	properties
 */
-Configuration read_config( std::string& in_scene, std::string& out_scene )
+Configuration read_config( const char* config_file, std::string& in_scene, std::string& out_scene )
 {
 	Configuration configuration;
 
+	// default values, used for missing entries too
+	in_scene = "scene/RefractScene.txt";
+	out_scene = "output/zout.png";
+	configuration.depth					= 10;
+	configuration.height				= 500;
+	configuration.width					= 500;
+	configuration.antialiasing_samples	= 10;
+	configuration.adaptive_antialiasing	= false;
+	configuration.adaptive_threshold	= 0.01f;
+	configuration.shadow_samples		= 1;
+	configuration.shadow_min_samples	= 0;
+	configuration.dof					= false;
+	configuration.dof_samples			= 1;
+	configuration.reflection_samples	= 1;
+	configuration.path_tracing			= false;
+	configuration.wavefront				= false;
+	configuration.sort_rays				= false;
+	configuration.window				= true;
+	configuration.tile_size				= 16;
+	configuration.seed					= 0u;
+	configuration.packets				= true;
+	configuration.scene_cache			= true;
+	configuration.progressive			= false;
+	configuration.time_limit			= 0.0f;
+	configuration.sampler				= Samplers::Type::random;
+
+	configuration.epsilon				= 0.01f;
 
 	// read config
 	std::ifstream file;
-	file.open( ".config" );
+	file.open( config_file );
 
-	// no config file -> set default values
+	// no config file -> keep default values
 	if ( !file )
+		return configuration;
+
+	// copy the file stream to the stream buffer
+	std::string file_data;
+	file.seekg( 0, std::ios::end );
+	file_data.reserve( file.tellg() );
+	file.seekg( 0, std::ios::beg );
+	file_data.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+
+	// close the file
+	file.close();
+
+	// read input file
+	size_t new_line;
+	new_line = file_data.find( '\n' );
+	in_scene = file_data.substr( 0u, new_line );
+	file_data = file_data.substr( new_line + 1u );
+
+	// read output file
+	new_line = file_data.find( '\n' );
+	out_scene = file_data.substr( 0u, new_line );
+	file_data = file_data.substr( new_line + 1u );
+
+	// read the "Key: value" entries in any order
+	int dof_samples = configuration.dof_samples;
+	while ( file_data.empty() == false )
 	{
-		in_scene = "scene/RefractScene.txt";
-		out_scene = "output/zout.png";
-		configuration.depth					= 10;
-		configuration.height				= 500;
-		configuration.width					= 500;
-		configuration.antialiasing_samples	= 10;
-		configuration.adaptive_antialiasing	= false;
-		configuration.shadow_samples		= 1;
-		configuration.dof_samples			= 1;
-		configuration.reflection_samples	= 1;
-		configuration.window				= true;
-
-		configuration.epsilon				= 0.01f;
-	}
-	else
-	{
-		// copy the file stream to the stream buffer
-		std::string file_data;
-		file.seekg( 0, std::ios::end );
-		file_data.reserve( file.tellg() );
-		file.seekg( 0, std::ios::beg );
-		file_data.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
-
-		// close the file
-		file.close();
-		
-		// read input file
-		size_t new_line;
 		new_line = file_data.find( '\n' );
-		in_scene = file_data.substr( 0u, new_line );
-		file_data = file_data.substr( new_line + 1u );
-
-		// read output file
-		new_line = file_data.find( '\n' );
-		out_scene = file_data.substr( 0u, new_line );
-		file_data = file_data.substr( new_line + 1u );
+		std::string line = file_data.substr( 0u, new_line );
+		file_data = new_line == std::string::npos ? std::string() : file_data.substr( new_line + 1u );
 
 		// read depth
-		configuration.depth	= static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		if ( line.rfind( "Depth:", 0u ) == 0u )
+			configuration.depth = static_cast<int>( read_val( line ) );
 
 		// read resolution
-		configuration.width	= static_cast<int>( read_val( file_data ) );
-		configuration.height = static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "Resolution:", 0u ) == 0u )
+		{
+			configuration.width	= static_cast<int>( read_val( line ) );
+			configuration.height = static_cast<int>( read_val( line ) );
+		}
 
 		// read antialiasing samples
-		configuration.antialiasing_samples = static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "AntialiasingSamples:", 0u ) == 0u )
+			configuration.antialiasing_samples = static_cast<int>( read_val( line ) );
 
 		// read adaptive samples flag
-		configuration.adaptive_antialiasing = static_cast<bool>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "AdaptiveAntialiasing:", 0u ) == 0u )
+			configuration.adaptive_antialiasing = static_cast<bool>( read_val( line ) );
+
+		// read adaptive sampling threshold
+		else if ( line.rfind( "AdaptiveThreshold:", 0u ) == 0u )
+			configuration.adaptive_threshold = read_val( line );
 
 		// read shadow samples
-		configuration.shadow_samples = static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "ShadowSamples:", 0u ) == 0u )
+			configuration.shadow_samples = static_cast<int>( read_val( line ) );
+
+		// read adaptive shadow samples
+		else if ( line.rfind( "ShadowMinSamples:", 0u ) == 0u )
+			configuration.shadow_min_samples = static_cast<int>( read_val( line ) );
 
 		// read dof flag
-		bool dof = static_cast<bool>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "DoF:", 0u ) == 0u )
+			configuration.dof = static_cast<bool>( read_val( line ) );
 
 		// read dof samples
-		configuration.dof_samples = static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
-
-		if ( dof == false )
-			configuration.dof_samples = 1;
+		else if ( line.rfind( "DoFSamples:", 0u ) == 0u )
+			dof_samples = static_cast<int>( read_val( line ) );
 
 		// read reflection samples
-		configuration.reflection_samples = static_cast<int>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "ReflectionSamples:", 0u ) == 0u )
+			configuration.reflection_samples = static_cast<int>( read_val( line ) );
+
+		// read path tracing flag
+		else if ( line.rfind( "PathTracing:", 0u ) == 0u )
+			configuration.path_tracing = static_cast<bool>( read_val( line ) );
+
+		// read wavefront flag
+		else if ( line.rfind( "Wavefront:", 0u ) == 0u )
+			configuration.wavefront = static_cast<bool>( read_val( line ) );
+
+		// read ray sorting flag
+		else if ( line.rfind( "SortRays:", 0u ) == 0u )
+			configuration.sort_rays = static_cast<bool>( read_val( line ) );
 
 		// read window flag
-		configuration.window = static_cast<bool>( read_val( file_data ) );
-		file_data = file_data.substr( 1u );
+		else if ( line.rfind( "Window:", 0u ) == 0u )
+			configuration.window = static_cast<bool>( read_val( line ) );
 
 		// read epsilon
-		configuration.epsilon = read_val( file_data );
-
+		else if ( line.rfind( "Epsilon:", 0u ) == 0u )
+			configuration.epsilon = read_val( line );
+
+		// read tile size
+		else if ( line.rfind( "TileSize:", 0u ) == 0u )
+			configuration.tile_size = static_cast<int>( read_val( line ) );
+
+		// read random seed
+		else if ( line.rfind( "Seed:", 0u ) == 0u )
+			configuration.seed = static_cast<unsigned>( read_val( line ) );
+
+		// read packets flag
+		else if ( line.rfind( "Packets:", 0u ) == 0u )
+			configuration.packets = static_cast<bool>( read_val( line ) );
+
+		// read scene cache flag
+		else if ( line.rfind( "SceneCache:", 0u ) == 0u )
+			configuration.scene_cache = static_cast<bool>( read_val( line ) );
+
+		// read progressive flag
+		else if ( line.rfind( "Progressive:", 0u ) == 0u )
+			configuration.progressive = static_cast<bool>( read_val( line ) );
+
+		// read time limit
+		else if ( line.rfind( "TimeLimit:", 0u ) == 0u )
+			configuration.time_limit = read_val( line );
+
+		// read sampler name
+		else if ( line.rfind( "Sampler:", 0u ) == 0u )
+		{
+			const std::string name = read_word( line );
+			if ( Samplers::parse_type( name, configuration.sampler ) == false )
+				std::cout << "Unknown sampler \"" << name << "\", using " << Samplers::type_name( configuration.sampler ) << std::endl;
+		}
 	}
+
+	configuration.dof_samples = configuration.dof ? dof_samples : 1;
+	if ( configuration.tile_size < 1 )
+		configuration.tile_size = 1;
+
 	return configuration;
 }
 
@@ -143,36 +230,175 @@ float read_val( std::string& data )
 	size_t end = new_line < space ? new_line : space;
 
 	result = static_cast< float >( std::atof( data.substr( 0u, end ).c_str() ) );
-	data = data.substr( end );
+	data = end == std::string::npos ? std::string() : data.substr( end );
 
 	return result;
 }
 
+/**
+* @brief read a word from a string
+* @param data		string to read from
+* @return word after the key, empty if there is none
+*/
+std::string read_word( std::string& data )
+{
+	size_t start = data.find_first_of( " \t" );
+	start = start == std::string::npos ? std::string::npos : data.find_first_not_of( " \t\r", start );
+	if ( start == std::string::npos )
+	{
+		data.clear();
+		return std::string();
+	}
+
+	size_t end = data.find_first_of( " \t\r\n", start );
+	std::string word = data.substr( start, end == std::string::npos ? std::string::npos : end - start );
+	data = end == std::string::npos ? std::string() : data.substr( end );
+
+	return word;
+}
+
+/**
+* @brief read a duration such as 30s, 500ms or 2m (seconds without a unit)
+* @param text		duration to read
+* @param seconds	duration in seconds (return)
+* @return false if the text is not a positive duration
+*/
+bool read_duration( const char* text, float& seconds )
+{
+	char* unit = nullptr;
+	const double value = std::strtod( text, &unit );
+
+	if ( unit == text || value <= 0.0 )
+		return false;
+
+	const std::string suffix = unit;
+	if ( suffix.empty() || suffix == "s" )
+		seconds = static_cast<float>( value );
+	else if ( suffix == "ms" )
+		seconds = static_cast<float>( value / 1000.0 );
+	else if ( suffix == "m" || suffix == "min" )
+		seconds = static_cast<float>( value * 60.0 );
+	else
+		return false;
+
+	return true;
+}
+
+/**
+* @brief load the compiled scene from its cache, or parse and compile the text scene (and update the cache)
+* @param in_scene			file path of input scene
+* @param config				properties
+* @param compiled_scene		output scene
+* @return false if the scene has errors
+*/
+bool load_scene( const std::string& in_scene, const Configuration& config, CompiledScene& compiled_scene )
+{
+	auto start = std::chrono::steady_clock::now();
+	const std::string cache_file = in_scene + ".cache";
+
+	if ( config.scene_cache && SceneCache::load( cache_file.c_str(), in_scene.c_str(), compiled_scene ) )
+	{
+		std::cout << "Loaded the compiled scene from " << cache_file << " in "
+				  << std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() << " ms" << std::endl;
+		return true;
+	}
+
+	// parse the text scene and flatten it for rendering
+	Scene scene;
+	try
+	{
+		scene.load_scene( in_scene.c_str() );
+	}
+	catch ( const ParseError& error )
+	{
+		std::cout << error.what() << std::endl;
+		return false;
+	}
+	compiled_scene.compile( scene );
+
+	// mesh loading stats
+	const Obj::Stats& obj_stats = scene.obj_stats();
+	if ( obj_stats.bytes > 0u )
+		std::cout << "Loaded " << obj_stats.triangles << " triangles (" << obj_stats.bytes / ( 1024.0 * 1024.0 ) << " MB of obj) in "
+				  << obj_stats.seconds * 1000.0 << " ms, " << obj_stats.throughput() << " MB/s" << std::endl;
+
+	std::cout << "Compiled the scene in " << std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() << " ms" << std::endl;
+
+	// a read only location only loses the cache
+	if ( config.scene_cache && SceneCache::save( cache_file.c_str(), in_scene.c_str(), scene.dependencies(), compiled_scene ) == false )
+		std::cout << "Unable to write the scene cache " << cache_file << std::endl;
+
+	return true;
+}
+
 /**
 * @brief main function
 * @param argc
-* @param argv
+* @param argv		optional path of the config file (.config by default), --time-limit <duration>
 */
 int main( int argc, char** argv )
 {
-	// read config
+	// read the arguments
+	const char* config_file = ".config";
+	float time_limit = 0.0f;
+	for ( int i = 1; i < argc; i++ )
+	{
+		const std::string argument = argv[i];
+		if ( argument == "--time-limit" )
+		{
+			if ( i + 1 >= argc || read_duration( argv[++i], time_limit ) == false )
+			{
+				std::cout << "--time-limit expects a duration such as 30s, 500ms or 2m" << std::endl;
+				return 1;
+			}
+		}
+		else
+			config_file = argv[i];
+	}
+
+	// read config, the arguments override it
 	Configuration config;
 	std::string input_file;
 	std::string output_file;
-	config = read_config( input_file, output_file );
+	config = read_config( config_file, input_file, output_file );
+	if ( time_limit > 0.0f )
+		config.time_limit = time_limit;
 
 
 
 	// command window prompt
 	std::cout << "Generating image for scene: " << input_file << " with size " << config.width * config.height << std::endl;
 
-	// load the scene
-	Scene scene( input_file.c_str() );
-
+	// load the scene ready for rendering
+	CompiledScene compiled_scene;
+	if ( load_scene( input_file, config, compiled_scene ) == false )
+		return 1;
+
+	// preview window only in the builds that have one
+	Preview* preview = nullptr;
+#ifdef CS500_PREVIEW
+	Window window;
+	if ( config.window == true )
+		preview = &window;
+#else
+	if ( config.window == true )
+		std::cout << "Preview window not available in this build, rendering without it" << std::endl;
+#endif
+
+	// progressive renders keep the output image up to date, it can be stopped at any time
+	// time limited renders save the image as soon as the time is up
+	Raytracer::PassCallback on_pass = nullptr;
+	if ( config.progressive == true || config.time_limit > 0.0f )
+	{
+		on_pass = [&]( const std::vector<unsigned char>& color_buffer )
+		{
+			Image::save_image( output_file.c_str(), config.width, config.height, color_buffer );
+		};
+	}
 
 	// compute image
 	std::vector<unsigned char> color_buffer;
-	if ( Raytracer::trace_scene( color_buffer, scene, config ) )
+	if ( Raytracer::trace_scene( color_buffer, compiled_scene, config, preview, on_pass ) )
 		// save image
 		Image::save_image( output_file.c_str(), config.width, config.height, color_buffer );
 
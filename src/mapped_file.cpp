@@ -0,0 +1,171 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: mapped_file.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+* @brief map a file
+* @param file_path
+*/
+MappedFile::MappedFile( const char* file_path )
+{
+	open( file_path );
+}
+
+/**
+* @brief unmap the file
+*/
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/**
+* @brief map a file, the previous one is closed
+* @param file_path
+* @return false if the file can not be opened
+*/
+bool MappedFile::open( const char* file_path )
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA( file_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if ( file == INVALID_HANDLE_VALUE )
+		return false;
+
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( file, &size ) )
+	{
+		CloseHandle( file );
+		return false;
+	}
+
+	m_file = file;
+	m_size = static_cast<size_t>( size.QuadPart );
+	m_open = true;
+
+	// a mapping of size 0 is not allowed
+	if ( m_size == 0u )
+		return true;
+
+	m_mapping = CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if ( m_mapping != nullptr )
+		m_data = static_cast<const char*>( MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 ) );
+#else
+	int file = ::open( file_path, O_RDONLY );
+	if ( file < 0 )
+		return false;
+
+	struct stat info;
+	if ( fstat( file, &info ) != 0 )
+	{
+		::close( file );
+		return false;
+	}
+
+	m_size = static_cast<size_t>( info.st_size );
+	m_open = true;
+
+	// a mapping of size 0 is not allowed
+	if ( m_size > 0u )
+	{
+		void* data = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0 );
+		if ( data != MAP_FAILED )
+		{
+			madvise( data, m_size, MADV_SEQUENTIAL );
+			m_data = static_cast<const char*>( data );
+		}
+	}
+
+	// the mapping keeps its own reference to the file
+	::close( file );
+#endif
+
+	if ( m_size > 0u && m_data == nullptr )
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+* @brief unmap the file
+*/
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if ( m_data != nullptr )
+		UnmapViewOfFile( m_data );
+	if ( m_mapping != nullptr )
+		CloseHandle( m_mapping );
+	if ( m_file != nullptr )
+		CloseHandle( m_file );
+
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if ( m_data != nullptr )
+		munmap( const_cast<char*>( m_data ), m_size );
+#endif
+
+	m_data = nullptr;
+	m_size = 0u;
+	m_open = false;
+}
+
+/**
+* @brief check if a file is mapped
+* @return true if open succeeded
+*/
+bool MappedFile::is_open() const
+{
+	return m_open;
+}
+
+/**
+* @brief get the contents of the file
+* @return first character, nullptr for empty files
+*/
+const char* MappedFile::data() const
+{
+	return m_data;
+}
+
+/**
+* @brief get the size of the file
+* @return size in bytes
+*/
+size_t MappedFile::size() const
+{
+	return m_size;
+}
+
+/**
+* @brief get the contents of the file
+* @return whole file
+*/
+std::string_view MappedFile::view() const
+{
+	return std::string_view( m_data, m_size );
+}
@@ -0,0 +1,50 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: mapped_file.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+/**
+* @brief read only view of a whole file mapped in memory
+*
+* The pages are loaded by the OS when they are touched, so nothing is copied and several
+* threads can read different parts of the file at the same time.
+*/
+class MappedFile
+{
+public:
+
+	MappedFile() = default;
+	explicit MappedFile( const char* file_path );
+	~MappedFile();
+
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	bool open( const char* file_path );
+	void close();
+
+	bool				is_open	() const;
+	const char*			data	() const;
+	size_t				size	() const;
+	std::string_view	view	() const;
+
+private:
+	const char*	m_data = nullptr;
+	size_t		m_size = 0u;
+	bool		m_open = false;		// empty files are open but have no mapping
+
+#ifdef _WIN32
+	void*		m_file		= nullptr;
+	void*		m_mapping	= nullptr;
+#endif
+};
@@ -0,0 +1,351 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: obj_loader.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "obj_loader.h"
+#include "mapped_file.h"
+#include "parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace
+{
+	// smaller pieces are not worth a thread
+	const size_t min_chunk_size = 1u << 20u;
+
+	// lines of the file handled by one thread
+	struct Chunk
+	{
+		size_t		begin = 0u;
+		size_t		end = 0u;
+
+		size_t		vertex_count = 0u;
+		size_t		triangle_count = 0u;
+		size_t		first_vertex = 0u;		// where the chunk writes in the final arrays
+		size_t		first_triangle = 0u;
+
+		std::string	error;					// empty if the chunk is valid
+		size_t		error_position = 0u;
+	};
+
+	enum class LineType { vertex, face, other };
+
+	/**
+	* @brief check for a separator inside a line
+	* @param c
+	* @return true for spaces, tabs and carriage returns
+	*/
+	bool is_blank( const char c )
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	/**
+	* @brief move to the start of the next token of the line
+	* @param data	whole file
+	* @param pos	position to update
+	* @param end	end of the line
+	* @return false if the line has no more tokens (a comment ends it too)
+	*/
+	bool next_token( std::string_view data, size_t& pos, const size_t end )
+	{
+		while ( pos < end && is_blank( data[pos] ) )
+			pos++;
+
+		return pos < end && data[pos] != '#';
+	}
+
+	/**
+	* @brief move to the end of the current token
+	* @param data	whole file
+	* @param pos	position to update
+	* @param end	end of the line
+	*/
+	void skip_token( std::string_view data, size_t& pos, const size_t end )
+	{
+		while ( pos < end && is_blank( data[pos] ) == false )
+			pos++;
+	}
+
+	/**
+	* @brief get the end of a line
+	* @param data	whole file
+	* @param pos	any position of the line
+	* @return position of the new line character (or the end of the file)
+	*/
+	size_t line_end( std::string_view data, const size_t pos )
+	{
+		size_t end = data.find( '\n', pos );
+		return end == std::string_view::npos ? data.size() : end;
+	}
+
+	/**
+	* @brief read the keyword of a line, only vertex positions and faces are used
+	* @param data	whole file
+	* @param pos	start of the line, moved after the keyword
+	* @param end	end of the line
+	* @return type of line
+	*/
+	LineType line_type( std::string_view data, size_t& pos, const size_t end )
+	{
+		if ( next_token( data, pos, end ) == false || pos + 1u >= end || is_blank( data[pos + 1u] ) == false )
+			return LineType::other;
+
+		const char keyword = data[pos];
+		pos += 1u;
+
+		if ( keyword == 'v' )
+			return LineType::vertex;
+		if ( keyword == 'f' )
+			return LineType::face;
+		return LineType::other;
+	}
+
+	/**
+	* @brief first pass, count the vertices and triangles of a chunk so the arrays can be sized once
+	* @param data	whole file
+	* @param chunk
+	*/
+	void count_chunk( std::string_view data, Chunk& chunk )
+	{
+		for ( size_t pos = chunk.begin; pos < chunk.end; pos++ )
+		{
+			const size_t end = line_end( data, pos );
+
+			LineType type = line_type( data, pos, end );
+
+			if ( type == LineType::vertex )
+				chunk.vertex_count++;
+
+			// polygons are fanned, n vertices give n - 2 triangles
+			else if ( type == LineType::face )
+			{
+				size_t count = 0u;
+				for ( ; next_token( data, pos, end ); count++ )
+					skip_token( data, pos, end );
+
+				if ( count > 2u )
+					chunk.triangle_count += count - 2u;
+			}
+
+			pos = end;
+		}
+	}
+
+	/**
+	* @brief second pass, parse a chunk into its part of the final arrays
+	* @param data			whole file
+	* @param chunk
+	* @param vertices		all the vertices of the file
+	* @param indices		all the triangles of the file
+	*/
+	void parse_chunk( std::string_view data, Chunk& chunk, std::vector<vec3>& vertices, std::vector<ivec3>& indices )
+	{
+		const char* text = data.data();
+		const int vertex_total = static_cast<int>( vertices.size() );
+
+		size_t vertex = chunk.first_vertex;
+		size_t triangle = chunk.first_triangle;
+
+		for ( size_t pos = chunk.begin; pos < chunk.end; pos++ )
+		{
+			const size_t end = line_end( data, pos );
+
+			LineType type = line_type( data, pos, end );
+
+			// v x y z [w]
+			if ( type == LineType::vertex )
+			{
+				vec3& position = vertices[vertex++];
+
+				for ( int i = 0; i < 3; i++ )
+				{
+					next_token( data, pos, end );
+
+					// from_chars does not accept an explicit positive sign
+					if ( pos < end && data[pos] == '+' )
+						pos++;
+
+					// parsed as double and rounded once, same values as atof
+					double value = 0.0;
+					auto result = std::from_chars( text + pos, text + end, value );
+
+					if ( result.ec != std::errc() )
+					{
+						chunk.error = "expected a vertex coordinate";
+						chunk.error_position = pos;
+						return;
+					}
+
+					position[i] = static_cast<float>( value );
+					pos = result.ptr - text;
+				}
+			}
+
+			// f v1[/vt1][/vn1] v2... only the position index is kept
+			else if ( type == LineType::face )
+			{
+				int first = 0;
+				int previous = 0;
+				int count = 0;
+
+				for ( ; next_token( data, pos, end ); count++ )
+				{
+					int value = 0;
+					auto result = std::from_chars( text + pos, text + end, value );
+
+					// positive indices start at 1, negative ones are relative to the last vertex read
+					int index = value > 0 ? value - 1 : static_cast<int>( vertex ) + value;
+
+					if ( result.ec != std::errc() || value == 0 || index < 0 || index >= vertex_total )
+					{
+						chunk.error = result.ec != std::errc() ? "expected a vertex index" : "vertex index out of range";
+						chunk.error_position = pos;
+						return;
+					}
+
+					if ( count == 0 )
+						first = index;
+					else if ( count > 1 )
+						indices[triangle++] = ivec3( first, previous, index );
+
+					previous = index;
+					skip_token( data, pos, end );
+				}
+
+				if ( count < 3 )
+				{
+					chunk.error = "a face needs at least 3 vertices";
+					chunk.error_position = pos;
+					return;
+				}
+			}
+
+			pos = end;
+		}
+	}
+
+	/**
+	* @brief run a function over every chunk, one thread per chunk
+	* @param chunks
+	* @param function	called with the chunk
+	*/
+	template <typename Function>
+	void for_each_chunk( std::vector<Chunk>& chunks, const Function& function )
+	{
+		std::vector<std::thread> threads;
+		threads.reserve( chunks.size() );
+
+		// the caller takes the first chunk
+		for ( size_t i = 1u; i < chunks.size(); i++ )
+			threads.emplace_back( [&function, &chunks, i]() { function( chunks[i] ); } );
+
+		function( chunks[0u] );
+
+		for ( auto& thread : threads )
+			thread.join();
+	}
+}
+
+namespace Obj
+{
+	/**
+	* @brief add the cost of another load
+	* @param other
+	*/
+	void Stats::add( const Stats& other )
+	{
+		bytes += other.bytes;
+		vertices += other.vertices;
+		triangles += other.triangles;
+		seconds += other.seconds;
+	}
+
+	/**
+	* @brief get the load speed
+	* @return MB per second
+	*/
+	double Stats::throughput() const
+	{
+		return seconds > 0.0 ? static_cast<double>( bytes ) / ( 1024.0 * 1024.0 ) / seconds : 0.0;
+	}
+
+	/**
+	* @brief read the vertex positions and triangles of an obj file
+	*
+	* The file is mapped in memory and split in chunks at line boundaries. A first parallel pass
+	* counts the vertices and triangles of every chunk, that gives the size of the arrays and
+	* where each chunk writes, and a second parallel pass parses the values in place.
+	*
+	* @param file_path
+	* @param vertices	output positions
+	* @param indices	output triangles (0 based), polygons are fanned
+	* @param stats		output cost of the load
+	* @return false if the file can not be opened
+	* @throw ParseError if the file has invalid data
+	*/
+	bool load( const char* file_path, std::vector<vec3>& vertices, std::vector<ivec3>& indices, Stats& stats )
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		MappedFile file( file_path );
+		if ( file.is_open() == false )
+			return false;
+
+		std::string_view data = file.view();
+
+		// split at line boundaries
+		unsigned thread_count = std::max( std::thread::hardware_concurrency(), 1u );
+		size_t chunk_count = std::clamp<size_t>( data.size() / min_chunk_size, 1u, thread_count );
+
+		std::vector<Chunk> chunks( chunk_count );
+		for ( size_t i = 1u; i < chunk_count; i++ )
+		{
+			size_t split = std::max( data.size() * i / chunk_count, chunks[i - 1u].begin );
+			chunks[i].begin = std::min( line_end( data, split ) + 1u, data.size() );
+			chunks[i - 1u].end = chunks[i].begin;
+		}
+		chunks.back().end = data.size();
+
+		for_each_chunk( chunks, [data]( Chunk& chunk ) { count_chunk( data, chunk ); } );
+
+		// where every chunk writes
+		size_t vertex_count = 0u;
+		size_t triangle_count = 0u;
+		for ( auto& chunk : chunks )
+		{
+			chunk.first_vertex = vertex_count;
+			chunk.first_triangle = triangle_count;
+			vertex_count += chunk.vertex_count;
+			triangle_count += chunk.triangle_count;
+		}
+
+		vertices.assign( vertex_count, vec3( 0.0f ) );
+		indices.assign( triangle_count, ivec3( 0 ) );
+
+		for_each_chunk( chunks, [data, &vertices, &indices]( Chunk& chunk ) { parse_chunk( data, chunk, vertices, indices ); } );
+
+		// report the first error of the file
+		for ( auto& chunk : chunks )
+			if ( chunk.error.empty() == false )
+				Parser( data, file_path ).error( chunk.error, chunk.error_position );
+
+		stats.bytes = data.size();
+		stats.vertices = vertex_count;
+		stats.triangles = triangle_count;
+		stats.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: obj_loader.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+#include <vector>
+
+namespace Obj
+{
+	// cost of the loads, added over every mesh of a scene
+	struct Stats
+	{
+		size_t	bytes		= 0u;
+		size_t	vertices	= 0u;
+		size_t	triangles	= 0u;
+		double	seconds		= 0.0;
+
+		void	add			( const Stats& other );
+		double	throughput	() const;	// MB/s
+	};
+
+	bool load( const char* file_path, std::vector<vec3>& vertices, std::vector<ivec3>& indices, Stats& stats );
+}
@@ -10,7 +10,7 @@ Creation date: 09/20/2019
 - End Header --------------------------------------------------------*/
 
 #include "opengl.h"
-#include <glad\glad.h>
+#include <glad/glad.h>
 
 #include <iostream>
 
@@ -123,7 +123,11 @@ std::vector<glm::vec<4, uint8_t>> save_screenshoot(uint32_t width, uint32_t heig
 {
 	auto pixels = take_screenshoot(width, height);
 	FILE* file; 
+#ifdef _MSC_VER
 	fopen_s( &file, filename, "wb" );
+#else
+	file = fopen( filename, "wb" );
+#endif
 
 	//#ifndef _WIN32
 	typedef struct                       /**** BMP file header structure ****/
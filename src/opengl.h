@@ -10,9 +10,9 @@ Creation date: 09/20/2019
 - End Header --------------------------------------------------------*/
 
 #pragma once
-#include <glad\glad.h>
+#include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <glm\glm.hpp>
+#include <glm/glm.hpp>
 
 #include <vector>
 #include <iostream>
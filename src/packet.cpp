@@ -0,0 +1,220 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: packet.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "packet.h"
+
+#include <limits>
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define PACKETS_X86
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define PACKETS_TARGET_AVX2
+#else
+#define PACKETS_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+namespace Packets
+{
+	/**
+	* @brief empty packet constructor
+	*/
+	RayPacket::RayPacket() :
+		direction( 0.0f ), count( 0u )
+	{
+		for ( unsigned i = 0u; i < max_width; i++ )
+		{
+			pos_x[i] = pos_y[i] = pos_z[i] = 0.0f;
+			inv_x[i] = inv_y[i] = inv_z[i] = 0.0f;
+			t_max[i] = -1.0f;
+		}
+	}
+
+	/**
+	* @brief add a ray in the next free lane
+	* @param ray
+	*/
+	void RayPacket::add( const Shapes::Ray& ray )
+	{
+		const unsigned lane = count++;
+
+		rays[lane] = ray;
+		pos_x[lane] = ray.pos.x;
+		pos_y[lane] = ray.pos.y;
+		pos_z[lane] = ray.pos.z;
+		inv_x[lane] = ray.inv_dir.x;
+		inv_y[lane] = ray.inv_dir.y;
+		inv_z[lane] = ray.inv_dir.z;
+		t_max[lane] = std::numeric_limits<float>::max();
+
+		direction += ray.dir;
+	}
+
+	/**
+	* @brief get the mask of the lanes with a ray
+	* @return mask
+	*/
+	unsigned RayPacket::active_mask() const
+	{
+		return ( 1u << count ) - 1u;
+	}
+
+	namespace
+	{
+#ifdef PACKETS_X86
+		/**
+		* @brief slab test of 4 lanes against a box with SSE
+		*/
+		unsigned intersect_box_sse( const Shapes::AABB& box, const RayPacket& packet )
+		{
+			const float* bounds_min = &box.min.x;
+			const float* bounds_max = &box.max.x;
+			const float* pos[3] = { packet.pos_x, packet.pos_y, packet.pos_z };
+			const float* inv[3] = { packet.inv_x, packet.inv_y, packet.inv_z };
+
+			__m128 t_near = _mm_setzero_ps();
+			__m128 t_far = _mm_load_ps( packet.t_max );
+
+			for ( int axis = 0; axis < 3; axis++ )
+			{
+				const __m128 p = _mm_load_ps( pos[axis] );
+				const __m128 d = _mm_load_ps( inv[axis] );
+				const __m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( bounds_min[axis] ), p ), d );
+				const __m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( bounds_max[axis] ), p ), d );
+
+				// the accumulated value is the second operand so NaN slabs are ignored
+				t_near = _mm_max_ps( _mm_min_ps( t0, t1 ), t_near );
+				t_far = _mm_min_ps( _mm_max_ps( t0, t1 ), t_far );
+			}
+
+			return static_cast<unsigned>( _mm_movemask_ps( _mm_cmple_ps( t_near, t_far ) ) );
+		}
+
+		/**
+		* @brief slab test of 8 lanes against a box with AVX
+		*/
+		PACKETS_TARGET_AVX2 unsigned intersect_box_avx2( const Shapes::AABB& box, const RayPacket& packet )
+		{
+			const float* bounds_min = &box.min.x;
+			const float* bounds_max = &box.max.x;
+			const float* pos[3] = { packet.pos_x, packet.pos_y, packet.pos_z };
+			const float* inv[3] = { packet.inv_x, packet.inv_y, packet.inv_z };
+
+			__m256 t_near = _mm256_setzero_ps();
+			__m256 t_far = _mm256_load_ps( packet.t_max );
+
+			for ( int axis = 0; axis < 3; axis++ )
+			{
+				const __m256 p = _mm256_load_ps( pos[axis] );
+				const __m256 d = _mm256_load_ps( inv[axis] );
+				const __m256 t0 = _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( bounds_min[axis] ), p ), d );
+				const __m256 t1 = _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( bounds_max[axis] ), p ), d );
+
+				// the accumulated value is the second operand so NaN slabs are ignored
+				t_near = _mm256_max_ps( _mm256_min_ps( t0, t1 ), t_near );
+				t_far = _mm256_min_ps( _mm256_max_ps( t0, t1 ), t_far );
+			}
+
+			return static_cast<unsigned>( _mm256_movemask_ps( _mm256_cmp_ps( t_near, t_far, _CMP_LE_OQ ) ) );
+		}
+
+		/**
+		* @brief check if the cpu and the os support AVX2
+		*/
+		bool has_avx2()
+		{
+#if defined( _MSC_VER )
+			int info[4];
+			__cpuid( info, 0 );
+			if ( info[0] < 7 )
+				return false;
+
+			// os saves the ymm registers
+			__cpuid( info, 1 );
+			if ( ( info[2] & ( 1 << 27 ) ) == 0 || ( _xgetbv( 0 ) & 6u ) != 6u )
+				return false;
+
+			__cpuidex( info, 7, 0 );
+			return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+		}
+#else
+		/**
+		* @brief slab test of 4 lanes against a box, one lane at a time (no SIMD available)
+		*/
+		unsigned intersect_box_generic( const Shapes::AABB& box, const RayPacket& packet )
+		{
+			unsigned mask = 0u;
+			for ( unsigned i = 0u; i < 4u; i++ )
+			{
+				float t_entry;
+				vec3 pos( packet.pos_x[i], packet.pos_y[i], packet.pos_z[i] );
+				vec3 inv( packet.inv_x[i], packet.inv_y[i], packet.inv_z[i] );
+				if ( packet.t_max[i] >= 0.0f && box.intersect( pos, inv, packet.t_max[i], t_entry ) )
+					mask |= 1u << i;
+			}
+			return mask;
+		}
+#endif
+
+		typedef unsigned ( *BoxKernel )( const Shapes::AABB&, const RayPacket& );
+
+		struct Kernel
+		{
+			BoxKernel	intersect_box;
+			unsigned	width;
+		};
+
+		/**
+		* @brief pick the widest kernel supported by the cpu running the program
+		*/
+		Kernel select_kernel()
+		{
+#ifdef PACKETS_X86
+			if ( has_avx2() )
+				return { intersect_box_avx2, 8u };
+			return { intersect_box_sse, 4u };
+#else
+			return { intersect_box_generic, 4u };
+#endif
+		}
+
+		const Kernel& kernel()
+		{
+			static const Kernel selected = select_kernel();
+			return selected;
+		}
+	}
+
+	/**
+	* @brief get the amount of rays per packet for this cpu (8 with AVX2, 4 otherwise)
+	* @return width
+	*/
+	unsigned width()
+	{
+		return kernel().width;
+	}
+
+	/**
+	* @brief test all the rays of a packet against a box
+	* @param box
+	* @param packet
+	* @return mask with a bit set for every ray hitting the box before its t_max
+	*/
+	unsigned intersect_box( const Shapes::AABB& box, const RayPacket& packet )
+	{
+		return kernel().intersect_box( box, packet );
+	}
+}
@@ -0,0 +1,60 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: packet.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "ray.h"
+#include "aabb.h"
+#include "math_utils.h"
+
+namespace Packets
+{
+	const unsigned max_width = 8u;
+
+	/**
+	* @brief group of rays traced together, stored as structure of arrays for the SIMD box test
+	*
+	* Lanes past count are inactive (negative t_max) so they never hit a box.
+	*/
+	struct RayPacket
+	{
+		alignas( 32 ) float pos_x[max_width];
+		alignas( 32 ) float pos_y[max_width];
+		alignas( 32 ) float pos_z[max_width];
+		alignas( 32 ) float inv_x[max_width];
+		alignas( 32 ) float inv_y[max_width];
+		alignas( 32 ) float inv_z[max_width];
+		alignas( 32 ) float t_max[max_width];
+
+		Shapes::Ray	rays[max_width];
+		vec3		direction;	// sum of the directions, used to order the children
+		unsigned	count;
+
+		RayPacket();
+		void add( const Shapes::Ray& ray );
+		unsigned active_mask() const;
+	};
+
+	unsigned width();
+	unsigned intersect_box( const Shapes::AABB& box, const RayPacket& packet );
+
+	/**
+	* @brief count the active rays in a mask
+	* @param mask
+	* @return amount of bits set
+	*/
+	inline unsigned count( unsigned mask )
+	{
+		unsigned result = 0u;
+		for ( ; mask != 0u; mask &= mask - 1u )
+			result++;
+		return result;
+	}
+}
@@ -0,0 +1,265 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: parser.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "parser.h"
+
+#include <charconv>
+#include <cmath>
+
+namespace
+{
+	bool is_space( const char c )
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}
+}
+
+/**
+* @brief parse error constructor
+* @param message	full message, with the location
+*/
+ParseError::ParseError( const std::string& message ) :
+	std::runtime_error( message )
+{}
+
+/**
+* @brief parser constructor
+* @param data	text to parse, must outlive the parser
+* @param name	name of the source used in the error messages
+*/
+Parser::Parser( std::string_view data, std::string_view name ) :
+	m_data( data ), m_name( name )
+{}
+
+/**
+* @brief skip white space and comments
+*/
+void Parser::skip_space()
+{
+	while ( m_pos < m_data.size() )
+	{
+		const char c = m_data[m_pos];
+
+		if ( is_space( c ) )
+			m_pos++;
+		// comment until the end of the line
+		else if ( c == '#' )
+		{
+			size_t end = m_data.find( '\n', m_pos );
+			m_pos = end == std::string_view::npos ? m_data.size() : end + 1u;
+		}
+		else
+			break;
+	}
+}
+
+/**
+* @brief skip white space only (inside a value)
+*/
+void Parser::skip_blank()
+{
+	while ( m_pos < m_data.size() && is_space( m_data[m_pos] ) )
+		m_pos++;
+}
+
+/**
+* @brief check if there is nothing left but white space and comments
+* @return true at the end of the data
+*/
+bool Parser::at_end()
+{
+	skip_space();
+	return m_pos >= m_data.size();
+}
+
+/**
+* @brief get the next word without consuming it
+* @return word, empty at the end of the data
+*/
+std::string_view Parser::peek_word()
+{
+	skip_space();
+
+	size_t end = m_pos;
+	while ( end < m_data.size() && is_space( m_data[end] ) == false )
+		end++;
+
+	return m_data.substr( m_pos, end - m_pos );
+}
+
+/**
+* @brief read the next white space separated word
+* @return word
+*/
+std::string_view Parser::read_word()
+{
+	std::string_view word = peek_word();
+
+	if ( word.empty() )
+		error( "unexpected end of file" );
+
+	m_pos += word.size();
+	return word;
+}
+
+/**
+* @brief read a number in place
+* @return value
+*/
+double Parser::read_number()
+{
+	skip_blank();
+
+	// from_chars does not accept an explicit positive sign
+	if ( m_pos < m_data.size() && m_data[m_pos] == '+' )
+		m_pos++;
+
+	double value = 0.0;
+	const char* begin = m_data.data() + m_pos;
+	const char* end = m_data.data() + m_data.size();
+	auto result = std::from_chars( begin, end, value );
+
+	if ( result.ec != std::errc() )
+		error( "expected a number" );
+
+	m_pos += result.ptr - begin;
+	return value;
+}
+
+/**
+* @brief read a white space separated float
+* @return value
+*/
+float Parser::read_float()
+{
+	skip_space();
+	const size_t start = m_pos;
+
+	// parsed as double and rounded once, same values as atof
+	float value = static_cast<float>( read_number() );
+
+	if ( m_pos < m_data.size() && is_space( m_data[m_pos] ) == false )
+		error( "unexpected character after number", start );
+
+	return value;
+}
+
+/**
+* @brief read a white space separated integer
+* @return value
+*/
+int Parser::read_int()
+{
+	skip_space();
+	const size_t start = m_pos;
+
+	double value = read_number();
+
+	if ( value != std::floor( value ) || ( m_pos < m_data.size() && is_space( m_data[m_pos] ) == false ) )
+		error( "expected an integer", start );
+
+	return static_cast<int>( value );
+}
+
+/**
+* @brief read a vector with the format (x,y)
+* @return vector
+*/
+vec2 Parser::read_vector2()
+{
+	skip_space();
+
+	vec2 vec;
+
+	expect( '(' );
+	vec.x = static_cast<float>( read_number() );
+	expect( ',' );
+	vec.y = static_cast<float>( read_number() );
+	expect( ')' );
+
+	return vec;
+}
+
+/**
+* @brief read a vector with the format (x,y,z)
+* @return vector
+*/
+vec3 Parser::read_vector()
+{
+	skip_space();
+
+	vec3 vec;
+
+	expect( '(' );
+	vec.x = static_cast<float>( read_number() );
+	expect( ',' );
+	vec.y = static_cast<float>( read_number() );
+	expect( ',' );
+	vec.z = static_cast<float>( read_number() );
+	expect( ')' );
+
+	return vec;
+}
+
+/**
+* @brief consume a character that must be next (white space is skipped)
+* @param character
+*/
+void Parser::expect( const char character )
+{
+	skip_blank();
+
+	if ( m_pos >= m_data.size() || m_data[m_pos] != character )
+		error( std::string( "expected '" ) + character + "'" );
+
+	m_pos++;
+}
+
+/**
+* @brief get the current position in the data
+* @return offset from the start
+*/
+size_t Parser::position() const
+{
+	return m_pos;
+}
+
+/**
+* @brief report an error at the current position
+* @param message
+*/
+void Parser::error( const std::string& message ) const
+{
+	error( message, m_pos );
+}
+
+/**
+* @brief report an error at a position of the data
+* @param message
+* @param position	offset from the start of the data
+*/
+void Parser::error( const std::string& message, const size_t position ) const
+{
+	// the location is only computed here, the parsing does not keep track of it
+	const size_t end = position < m_data.size() ? position : m_data.size();
+	size_t line = 1u;
+	size_t line_start = 0u;
+
+	for ( size_t i = 0u; i < end; i++ )
+	{
+		if ( m_data[i] == '\n' )
+		{
+			line++;
+			line_start = i + 1u;
+		}
+	}
+
+	throw ParseError( std::string( m_name ) + ":" + std::to_string( line ) + ":" + std::to_string( end - line_start + 1u ) + ": " + message );
+}
@@ -0,0 +1,64 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: parser.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+* @brief error found while reading a text file, the message starts with file:line:column
+*/
+class ParseError : public std::runtime_error
+{
+public:
+	explicit ParseError( const std::string& message );
+};
+
+/**
+* @brief single forward pass over the text of a file
+*
+* Tokens are separated by white space, values are read in place with std::from_chars
+* so nothing is copied. Lines starting with # are comments. The line and column are
+* only computed when an error is reported.
+*/
+class Parser
+{
+public:
+
+	Parser( std::string_view data, std::string_view name );
+
+	bool				at_end		();
+	std::string_view	peek_word	();
+	std::string_view	read_word	();
+	float				read_float	();
+	int					read_int	();
+	vec2				read_vector2();
+	vec3				read_vector	();
+
+	[[noreturn]] void	error		( const std::string& message ) const;
+	[[noreturn]] void	error		( const std::string& message, const size_t position ) const;
+
+	size_t				position	() const;
+
+private:
+
+	void	skip_space		();
+	void	skip_blank		();
+	void	expect			( const char character );
+	double	read_number		();
+
+private:
+	std::string_view	m_data;
+	std::string_view	m_name;		// for the error messages
+	size_t				m_pos = 0u;
+};
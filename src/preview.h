@@ -0,0 +1,32 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: preview.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <vector>
+
+/**
+* @brief front end showing the image while it is rendered
+*
+* The raytracer only knows this interface, so the core does not depend on any windowing
+* library. The GLFW window is one implementation, headless builds pass no preview.
+*/
+class Preview
+{
+public:
+
+	virtual ~Preview() = default;
+
+	virtual void initialize( const int width, const int height, const std::vector<unsigned char>& color_buffer ) = 0;
+	virtual void render( const std::vector<unsigned char>& color_buffer ) = 0;
+	virtual void exit() = 0;
+
+	virtual bool should_close() = 0;
+};
@@ -0,0 +1,83 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: random.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <cstdint>
+
+/**
+* @brief PCG32 random number generator (O'Neill, pcg-random.org)
+*
+* Small enough to live on the stack of each thread. Different sequences with the same
+* seed are independent, the raytracer uses the pixel index as the sequence so every
+* pixel gets the same numbers no matter which thread renders it.
+*/
+class Random
+{
+public:
+
+	Random( const uint64_t seed = 0u, const uint64_t sequence = 0u );
+
+	void		seed		( const uint64_t seed, const uint64_t sequence );
+	uint32_t	next		();
+	float		next_float	();
+
+private:
+	uint64_t m_state;
+	uint64_t m_increment;
+};
+
+/**
+* @brief random generator constructor
+* @param seed		initial state
+* @param sequence	stream to draw the numbers from
+*/
+inline Random::Random( const uint64_t seed, const uint64_t sequence )
+{
+	this->seed( seed, sequence );
+}
+
+/**
+* @brief restart the generator
+* @param seed		initial state
+* @param sequence	stream to draw the numbers from
+*/
+inline void Random::seed( const uint64_t seed, const uint64_t sequence )
+{
+	m_state = 0u;
+	m_increment = ( sequence << 1u ) | 1u;
+	next();
+	m_state += seed;
+	next();
+}
+
+/**
+* @brief get the next random number
+* @return uniformly distributed 32 bit value
+*/
+inline uint32_t Random::next()
+{
+	uint64_t old_state = m_state;
+	m_state = old_state * 6364136223846793005ull + m_increment;
+
+	uint32_t xorshifted = static_cast<uint32_t>( ( ( old_state >> 18u ) ^ old_state ) >> 27u );
+	uint32_t rotation = static_cast<uint32_t>( old_state >> 59u );
+	return ( xorshifted >> rotation ) | ( xorshifted << ( ( 0u - rotation ) & 31u ) );
+}
+
+/**
+* @brief get the next random number as a float
+* @return uniformly distributed value in [0, 1)
+*/
+inline float Random::next_float()
+{
+	// 24 bits fit exactly in the mantissa
+	return static_cast<float>( next() >> 8u ) * ( 1.0f / 16777216.0f );
+}
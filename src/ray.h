@@ -0,0 +1,26 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: ray.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+
+namespace Shapes
+{
+	struct Ray
+	{
+		vec3	pos;
+		vec3	dir;
+		vec3	inv_dir;	// for the slab tests
+
+		Ray() = default;
+		Ray( const vec3& pos, const vec3& dir );
+	};
+}
@@ -9,9 +9,17 @@ Creation date: 01/13/2020
 ----------------------------------------------------------------------------------------------------------*/
 
 #include "raytracer.h"
-#include "window.h"
+#include "sampling.h"
+#include "scheduler.h"
+#include "wavefront.h"
 
 #include <glm/gtc/random.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <list>
 #include <iostream>
 #include <random>
@@ -19,16 +27,92 @@ Creation date: 01/13/2020
 
 namespace Raytracer
 {
-	void					trace_chunk				( std::vector<unsigned char>& color_buffer, const Scene& scene, const Configuration& config, const int thread_count, const int thread_id, const bool* terminate );
-	vec3					adaptive_sampling		( const Scene& scene, const Configuration& config, const vec3 center, const vec3 sample_offset_x, const vec3 sample_offset_y, const int depth = 0 );
-	vec3					compute_pixel			( const Scene& scene, const Shapes::Ray& ray, const Configuration& config, const float e_permittivity, const float m_permeability, const int depth = 0 );
+	// shadow points of a light mapped to the sphere together
+	const int shadow_batch = 16;
 
-	Intersection::Contact	raycast_scene			( const Scene& scene, const Shapes::Ray& ray );
-	vec3					raycast_lights			( const Scene& scene, const Shapes::Ray& ray, const int samples, const vec3 contact_point, const vec3 contact_normal, const Material& material );
+	// work done on each tile handed out by the scheduler
+	using TileWork = std::function<void( const Tile& tile )>;
 
-	vec3					get_random_sample		( const vec3& pos, const float radius );
-	float					compute_reflection_coeff( const float eps_i, const float nu_i, const float eps_t, const float nu_t, const float incident_angle );
-	Shapes::Ray				compute_ray_dir_dof		( const Camera& camera, const vec3& pixel_pos, const float focal_point );
+	// running sums of a progressive render, one entry per pixel
+	struct Accumulation
+	{
+		std::vector<vec3>		color;		// sum of the samples
+		std::vector<float>		luminance;	// sum of the luminance of the samples, for the variance
+		std::vector<float>		squared;	// sum of the squared luminance of the samples
+		std::vector<unsigned>	samples;	// amount of samples added
+		std::vector<Random>		rngs;		// sequence of the pixel, continued by every pass
+	};
+
+	// contact being shaded, resumed after each of the rays it spawns
+	struct ShadeFrame
+	{
+		enum class PathRay { none, refraction, mirror, rough };
+
+		Shapes::Ray	ray;					// ray that hit the contact
+		vec3		normal;					// facing the ray
+		vec3		contact_point_out;
+		vec3		contact_point_in;
+		vec3		color;					// direct light plus the rays done so far
+		vec3		reflection_color;		// sum of the reflection samples done so far
+		vec3		attenuation;			// air attenuation from the ray origin
+		float		e_permittivity;			// medium of the ray
+		float		m_permeability;
+		float		next_e_permittivity;	// medium on the other side of the surface
+		float		next_m_permeability;
+		float		reflection;				// fresnel weights
+		float		transmission;
+		float		roughness;
+		float		throughput;				// fraction of the light reaching the camera, with the attenuation
+		float		scale;					// weight of the ray of path tracing
+		int			depth;
+		int			samples;				// reflection samples
+		int			next;					// rays spawned so far
+		unsigned	reflection_dimension;	// sampler dimension of the rough reflection samples
+		bool		path;					// flag for a single ray (path tracing)
+		PathRay		path_ray;				// single ray to follow
+	};
+
+	// camera samples of one level of the adaptive lattice, each pixel owns the points of its top left
+	// corner, top row and left column (one more row and column of owners cover the right and bottom border)
+	struct LatticeLevel
+	{
+		int						cells = 1;	// cells per pixel side, 2^level
+		std::vector<size_t>		offsets;	// first point of every owner, none if the owner is not refined that far
+		std::vector<vec3>		colors;		// cells x cells points of every owner
+	};
+
+	void					trace_tiles				( const Configuration& config, const TileWork& work, std::atomic<bool>& terminate, Preview* preview, const std::vector<unsigned char>& color_buffer );
+	void					trace_tiles_thread		( TileScheduler& scheduler, const unsigned thread_id, const TileWork& work, std::atomic<bool>& terminate, Preview* preview, const std::vector<unsigned char>& color_buffer );
+	void					trace_progressive		( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview, const PassCallback& on_pass );
+	void					trace_adaptive			( std::vector<vec3>& colors, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview );
+	void					build_lattice_level		( LatticeLevel& lattice, const std::vector<int>& levels, const Configuration& config, const int level );
+	void					trace_lattice_tile		( LatticeLevel& lattice, const LatticeLevel& coarse, const std::vector<int>& levels, const CompiledScene& scene, const Configuration& config, const Tile& tile, const int level, const int max_level, std::atomic<size_t>& rays );
+	void					resolve_lattice_tile	( std::vector<vec3>& colors, std::vector<int>& levels, std::vector<unsigned char>& color_buffer, const LatticeLevel& lattice, const Configuration& config, const Tile& tile, const int level, const int max_level );
+	bool					lattice_point_needed	( const std::vector<int>& levels, const Configuration& config, const int x, const int y, const int a, const int b, const int level );
+	const vec3&				lattice_color			( const LatticeLevel& lattice, const Configuration& config, const int i, const int j, const int a, const int b );
+	void					trace_tile				( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::atomic<bool>& terminate );
+	void					trace_tile_packets		( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::atomic<bool>& terminate );
+	void					trace_tile_pass			( Accumulation& accumulation, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const int pass );
+	void					trace_tile_noisy		( Accumulation& accumulation, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::vector<char>& noisy );
+	void					add_sample				( Accumulation& accumulation, const size_t index, const vec3& color );
+	float					display_luminance		( const vec3& color );
+	bool					select_noisy_pixels		( const Accumulation& accumulation, std::vector<char>& noisy );
+	void					report_samples			( const Accumulation& accumulation, const Configuration& config, const double seconds );
+	vec3					trace_pixel				( const CompiledScene& scene, const Configuration& config, const int i, const int j );
+	vec3					trace_sample			( const CompiledScene& scene, const Configuration& config, const int i, const int j, const int sample, Random& rng );
+	void					trace_sample_packet		( const CompiledScene& scene, const Configuration& config, const int* rows, const int* columns, const unsigned count, const int sample, Random* rngs, vec3* colors );
+	vec3					compute_pixel			( const CompiledScene& scene, const Shapes::Ray& ray, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth = 0, const float throughput = 1.0f );
+	vec3					shade_contact			( const CompiledScene& scene, const Shapes::Ray& ray, const Intersection::Contact& contact, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth, const float throughput = 1.0f );
+
+	void					begin_shading			( ShadeFrame& frame, const CompiledScene& scene, const Shapes::Ray& ray, const Intersection::Contact& contact, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth, const float throughput );
+	bool					spawn_ray				( ShadeFrame& frame, Sampler& sampler, Shapes::Ray& ray, float& e_permittivity, float& m_permeability, float& throughput );
+	void					add_ray_color			( ShadeFrame& frame, const vec3& color );
+	vec3					end_shading				( const ShadeFrame& frame );
+
+	vec3					raycast_lights			( const CompiledScene& scene, const Shapes::Ray& ray, Sampler& sampler, const int samples, const int min_samples, const vec3 contact_point, const vec3 contact_normal, const Material& material );
+	int						count_occlusions		( const CompiledScene& scene, const Lights::Point& light, const vec3& contact_point, const float light_dist, Sampler& sampler, const unsigned dimension, const int begin, const int end, const int count );
+
+	Shapes::Ray				compute_ray_dir_dof		( const Camera& camera, const vec3& pixel_pos, const float focal_point, Sampler& sampler );
 	float					compute_focal_point		( const Camera& camera, const float axis_offset );
 
 	/**
@@ -36,8 +120,10 @@ namespace Raytracer
 	* @param color_buffer		result color buffer in chars
 	* @param scene				scene to render
 	* @param config				raytracer properties
+	* @param preview			front end to show the image while rendering (nullptr for none)
+	* @param on_pass			called after every pass of a progressive render (optional)
 	*/
-	bool trace_scene( std::vector<unsigned char>& color_buffer, const Scene& scene, const Configuration& config )
+	bool trace_scene( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, Preview* preview, const PassCallback& on_pass )
 	{
 
 		// resize buffer
@@ -49,208 +135,958 @@ namespace Raytracer
 			color_buffer[i + 2] = 0;
 		}
 
-		// generate window if enabled
-		Window window;
-		if ( config.window == true )
-			window.initialize( config.width, config.height, color_buffer );
-
-		// color buffer
-		std::vector<char> buffer( config.height * config.width );
+		// open the preview if any
+		if ( preview != nullptr )
+			preview->initialize( config.width, config.height, color_buffer );
 
-		// threads
-		unsigned thread_count = std::thread::hardware_concurrency() - 1u;
-		if ( thread_count == 0u ) thread_count = 1u;
-
-		std::vector<std::thread*>	threads;
-		bool terminate = false;
+		std::atomic<bool> terminate( false );
 
 		// raytrace
-		for ( unsigned i = 0u; i < thread_count; i++ )
-			threads.push_back( new std::thread( trace_chunk, std::ref( color_buffer ), std::ref( scene ), config, thread_count, i, &terminate ) );
+		if ( config.progressive == true || config.time_limit > 0.0f )
+			trace_progressive( color_buffer, scene, config, terminate, preview, on_pass );
+		else if ( config.adaptive_antialiasing == true )
+		{
+			std::vector<vec3> colors;
+			trace_adaptive( colors, color_buffer, scene, config, terminate, preview );
+		}
+		else if ( config.wavefront == true )
+			trace_wavefront( color_buffer, scene, config, terminate, preview );
+		else
+		{
+			trace_tiles( config, [&]( const Tile& tile )
+			{
+				trace_tile( color_buffer, scene, config, tile, terminate );
+			}, terminate, preview, color_buffer );
+		}
 
 		// rendering
-		if ( config.window == true )
+		if ( preview != nullptr )
 		{
-			// wait for closing window
-			while ( window.should_close() == false )
-				window.render( color_buffer );
+			// wait for the preview to be closed
+			while ( terminate == false && preview->should_close() == false )
+				preview->render( color_buffer );
 	
 			// flag to end threads
 			terminate = true;
 		}
+	
+		// close the preview
+		if ( preview != nullptr )
+			preview->exit();
+
+		return true;
+	}
 
-		// delete threads
-		for ( auto thread = threads.begin(); thread != threads.end(); thread++ )
+	/**
+	* @brief split the image in tiles and work on them with all the hardware threads
+	* @param config				raytracer values
+	* @param work				what to do with each tile
+	* @param terminate			flag to stop rendering
+	* @param preview			preview to refresh while working (nullptr for none)
+	* @param color_buffer		image shown in the preview
+	*/
+	void trace_tiles( const Configuration& config, const TileWork& work, std::atomic<bool>& terminate, Preview* preview, const std::vector<unsigned char>& color_buffer )
+	{
+		// the caller is thread 0
+		TileScheduler scheduler( config.width, config.height, config.tile_size, TileScheduler::hardware_threads() );
+
+		std::vector<std::thread>	threads;
+		std::atomic<unsigned>		running( scheduler.thread_count() - 1u );
+
+		for ( unsigned i = 1u; i < scheduler.thread_count(); i++ )
 		{
-			if ( ( *thread ) != nullptr )
+			threads.emplace_back( [&, i]()
 			{
-				( *thread )->join();
-				delete ( *thread );
-			}
+				trace_tiles_thread( scheduler, i, work, terminate, nullptr, color_buffer );
+				running--;
+			} );
 		}
-	
-		// remove window
-		if ( config.window == true )
-			window.exit();
 
-		return true;
+		trace_tiles_thread( scheduler, 0u, work, terminate, preview, color_buffer );
+
+		// keep the preview alive until the last tiles are done
+		while ( preview != nullptr && running > 0u && terminate == false )
+		{
+			if ( preview->should_close() )
+				terminate = true;
+			else
+				preview->render( color_buffer );
+		}
+
+		// wait for the threads
+		for ( auto& thread : threads )
+			thread.join();
 	}
 
 	/**
-	* @brief compute the color value of the pixel assigned to the thread
-	* @param color_buffer		result color buffer in chars
+	* @brief work on tiles until there are none left
+	* @param scheduler			source of the tiles
+	* @param thread_id			id of the current thread
+	* @param work				what to do with each tile
+	* @param terminate			flag to stop rendering
+	* @param preview			preview to refresh between tiles (only for the thread owning it)
+	* @param color_buffer		image shown in the preview
+	*/
+	void trace_tiles_thread( TileScheduler& scheduler, const unsigned thread_id, const TileWork& work, std::atomic<bool>& terminate, Preview* preview, const std::vector<unsigned char>& color_buffer )
+	{
+		const auto refresh_period = std::chrono::milliseconds( 33 );
+		auto last_refresh = std::chrono::steady_clock::now();
+
+		Tile tile;
+		while ( terminate == false && scheduler.next_tile( thread_id, tile ) )
+		{
+			work( tile );
+
+			// keep the preview alive while working
+			if ( preview != nullptr && std::chrono::steady_clock::now() - last_refresh > refresh_period )
+			{
+				if ( preview->should_close() )
+					terminate = true;
+				else
+					preview->render( color_buffer );
+
+				last_refresh = std::chrono::steady_clock::now();
+			}
+		}
+	}
+
+	/**
+	* @brief render the image in passes of one sample per pixel, the preview is refreshed after every pass
+	*
+	* The samples are added to a float buffer with the amount of samples of each pixel, so the
+	* image is usable whenever the render is stopped. Each pixel keeps its random sequence between
+	* passes and gets the same samples as when it is computed in one go.
+	*
+	* With a time limit the passes stop at the deadline (the first one is always complete). If the
+	* configured samples are done before it, the rest of the time goes to rounds of one more sample
+	* for the quarter of the pixels with the highest standard error.
+	* @param color_buffer		result color buffer in chars, average of the samples so far
 	* @param scene				scene to render
 	* @param config				raytracer values
-	* @param thread_count		maximum amount of threads
-	* @param thread_id			id of the current thread
+	* @param terminate			flag to stop rendering
+	* @param preview			front end to show the image while rendering (nullptr for none)
+	* @param on_pass			called with the image after every pass (optional)
 	*/
-	void trace_chunk( std::vector<unsigned char>& color_buffer, const Scene& scene, const Configuration& config, const int thread_count, const int thread_id, const bool* terminate )
+	void trace_progressive( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview, const PassCallback& on_pass )
 	{
-		// get camera
-		Camera camera = scene.camera();
+		const auto start = std::chrono::steady_clock::now();
+		const bool timed = config.time_limit > 0.0f;
+		const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<float>( config.time_limit ) );
+		auto past_deadline = [&]() { return timed && std::chrono::steady_clock::now() >= deadline; };
+
+		const size_t pixel_count = static_cast<size_t>( config.width ) * config.height;
+
+		Accumulation accumulation;
+		accumulation.color.assign( pixel_count, vec3( 0.0f ) );
+		accumulation.luminance.assign( pixel_count, 0.0f );
+		accumulation.squared.assign( pixel_count, 0.0f );
+		accumulation.samples.assign( pixel_count, 0u );
+		accumulation.rngs.resize( pixel_count );
+		for ( size_t i = 0u; i < pixel_count; i++ )
+			accumulation.rngs[i].seed( config.seed, i );
+
+		// show the image of the pass, the time limited renders only save the last one
+		auto end_pass = [&]()
+		{
+			if ( on_pass != nullptr && ( config.progressive == true || past_deadline() ) )
+				on_pass( color_buffer );
 
-		const float half_width  = static_cast<float>( config.width ) / 2.0f;
-		const float half_height = static_cast<float>( config.height ) / 2.0f;
+			if ( preview != nullptr )
+			{
+				if ( preview->should_close() )
+					terminate = true;
+				else
+					preview->render( color_buffer );
+			}
+		};
 
-		const int pixel_size = static_cast<int>( sqrt( config.antialiasing_samples ) );
-		const float half_pixel_size = static_cast<float>( pixel_size ) / 2.0f;
-		const vec3  half_pixel_width  = camera.u / static_cast<float>( config.width ) / 2.0f;
-		const vec3  half_pixel_height = camera.v / static_cast<float>( config.height ) / 2.0f;
+		// adaptive antialiasing samples the whole image at once -> a single sample per pixel
+		if ( config.adaptive_antialiasing == true )
+		{
+			std::vector<vec3> colors;
+			trace_adaptive( colors, color_buffer, scene, config, terminate, preview );
+
+			for ( size_t i = 0u; i < pixel_count; i++ )
+				add_sample( accumulation, i, colors[i] );
 
-		for ( int i = thread_id; i < config.height; i += thread_count )
+			if ( terminate == false )
+				end_pass();
+		}
+
+		const int passes = config.adaptive_antialiasing ? 0 : pixel_samples( config );
+
+		for ( int pass = 0; pass < passes && terminate == false && ( pass == 0 || past_deadline() == false ); pass++ )
 		{
-			// compute the y value for the current row
-			vec3 y = ( static_cast<float>( i ) - half_height + 0.5f ) / half_height * camera.v;
+			trace_tiles( config, [&]( const Tile& tile )
+			{
+				// tiles not reached in time keep the samples of the previous pass
+				if ( pass == 0 || past_deadline() == false )
+					trace_tile_pass( accumulation, color_buffer, scene, config, tile, pass );
+			}, terminate, preview, color_buffer );
 
+			// the image is complete for this amount of samples
+			if ( terminate == true )
+				break;
 
-			for ( int j = 0; j < config.width; j++ )
+			end_pass();
+		}
+
+		if ( timed == false )
+			return;
+
+		// spend the rest of the time on the noisiest pixels
+		std::vector<char> noisy( pixel_count, 0 );
+		while ( terminate == false && past_deadline() == false && select_noisy_pixels( accumulation, noisy ) )
+		{
+			trace_tiles( config, [&]( const Tile& tile )
 			{
-				vec3 color( 0.0f );
+				if ( past_deadline() == false )
+					trace_tile_noisy( accumulation, color_buffer, scene, config, tile, noisy );
+			}, terminate, preview, color_buffer );
+
+			if ( terminate == true )
+				break;
 
-				// compute the x value for the current column
-				vec3 x = ( static_cast<float>( j ) - half_width + 0.5f ) / half_width * camera.u;
+			end_pass();
+		}
 
+		// converged before the deadline, the last image was not saved yet
+		if ( terminate == false && past_deadline() == false && config.progressive == false && on_pass != nullptr )
+			on_pass( color_buffer );
 
-				// spherical aberration
-				vec2 axis_offset = {
-					( static_cast<float>( j ) - half_width  + 0.5f ) / half_width,
-					( static_cast<float>( i ) - half_height + 0.5f ) / half_height
-				};
-				float axis_dist = sqrt( axis_offset.x * axis_offset.x + axis_offset.y * axis_offset.y ) * camera.aperture;
-				float focal_point = compute_focal_point( camera, axis_dist );
+		report_samples( accumulation, config, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+	}
 
-				// adaptive antialiasing
-				if ( config.adaptive_antialiasing == true )
+	/**
+	* @brief compute the color value of the pixels in a tile
+	* @param color_buffer		result color buffer in chars
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param tile				pixels to compute
+	* @param terminate			flag to stop rendering
+	*/
+	void trace_tile( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::atomic<bool>& terminate )
+	{
+		if ( config.packets == true )
+		{
+			trace_tile_packets( color_buffer, scene, config, tile, terminate );
+			return;
+		}
+
+		for ( int i = tile.y; i < tile.y + tile.height; i++ )
+		{
+			for ( int j = tile.x; j < tile.x + tile.width; j++ )
+				write_pixel( color_buffer, config, i, j, trace_pixel( scene, config, i, j ) );
+
+			if ( terminate == true )
+				return;
+		}
+	}
+
+	/**
+	* @brief compute the color value of the pixels in a tile tracing the camera rays in packets
+	* @param color_buffer		result color buffer in chars
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param tile				pixels to compute
+	* @param terminate			flag to stop rendering
+	*/
+	void trace_tile_packets( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::atomic<bool>& terminate )
+	{
+		// block of neighbouring pixels, one ray of each per packet (2x2 or 4x2)
+		const int block_width = Packets::width() == 8u ? 4 : 2;
+		const int block_height = 2;
+
+		const int samples = pixel_samples( config );
+
+		for ( int y = tile.y; y < tile.y + tile.height; y += block_height )
+		{
+			for ( int x = tile.x; x < tile.x + tile.width; x += block_width )
+			{
+				// pixels of the block inside the tile
+				int		rows[Packets::max_width];
+				int		columns[Packets::max_width];
+				Random	rngs[Packets::max_width];
+				vec3	colors[Packets::max_width];
+				unsigned count = 0u;
+
+				for ( int i = y; i < std::min( y + block_height, tile.y + tile.height ); i++ )
 				{
-					vec3 pixel_pos = x - y + camera.center;
-					color = adaptive_sampling( scene, config, pixel_pos, half_pixel_width / 2.0f, half_pixel_height / 2.0f );
+					for ( int j = x; j < std::min( x + block_width, tile.x + tile.width ); j++ )
+					{
+						rows[count] = i;
+						columns[count] = j;
+						rngs[count].seed( config.seed, static_cast<uint64_t>( i ) * config.width + j );
+						colors[count] = vec3( 0.0f );
+						count++;
+					}
 				}
-				else	// supersampling antialiasing
+
+				// same sample of every pixel in the block -> coherent packet
+				for ( int sample = 0; sample < samples; sample++ )
+					trace_sample_packet( scene, config, rows, columns, count, sample, rngs, colors );
+
+				// color average
+				for ( unsigned p = 0u; p < count; p++ )
+					write_pixel( color_buffer, config, rows[p], columns[p], colors[p] / static_cast<float>( config.antialiasing_samples * config.dof_samples ) );
+			}
+
+			if ( terminate == true )
+				return;
+		}
+	}
+
+	/**
+	* @brief add one sample to every pixel of a tile and update their color
+	* @param accumulation		sums of the samples of every pixel
+	* @param color_buffer		result color buffer in chars
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param tile				pixels to compute
+	* @param pass				index of the sample
+	*/
+	void trace_tile_pass( Accumulation& accumulation, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const int pass )
+	{
+		// same sample of every pixel in the block -> coherent packet
+		if ( config.packets == true )
+		{
+			const int block_width = Packets::width() == 8u ? 4 : 2;
+			const int block_height = 2;
+
+			for ( int y = tile.y; y < tile.y + tile.height; y += block_height )
+			{
+				for ( int x = tile.x; x < tile.x + tile.width; x += block_width )
 				{
-					// add offset inside pixel
-					for ( int k = 0; k < pixel_size; k++ )
-					{
-						vec3 pixel_y = ( static_cast<float>( k ) - half_pixel_size + 0.5f ) / half_pixel_size * half_pixel_height;
+					int		rows[Packets::max_width];
+					int		columns[Packets::max_width];
+					Random	rngs[Packets::max_width];
+					vec3	colors[Packets::max_width];
+					unsigned count = 0u;
 
-						for ( int l = 0; l < pixel_size; l++ )
+					for ( int i = y; i < std::min( y + block_height, tile.y + tile.height ); i++ )
+					{
+						for ( int j = x; j < std::min( x + block_width, tile.x + tile.width ); j++ )
 						{
-							vec3 pixel_x = ( static_cast<float>( l ) - half_pixel_size + 0.5f ) / half_pixel_size * half_pixel_width;
-
-							// create the ray for the current pixel
-							vec3 pixel_pos = x + pixel_x - y - pixel_y + camera.center;
-
-							for ( int m = 0; m < config.dof_samples; m++ )
-							{
-								Shapes::Ray ray;
-								if ( m == 0 )
-								{
-									ray.pos = camera.pos;
-									ray.dir = normalize( pixel_pos - camera.pos );
-								}
-								else
-								{
-									ray = compute_ray_dir_dof( camera, pixel_pos, focal_point );
-								}
-
-								// compute the value of the pixel and set it to the buffer
-								color += compute_pixel( scene, ray, config, scene.air().electric_permitivity, scene.air().magnetic_permeability );
-							}
+							const size_t index = static_cast<size_t>( i ) * config.width + j;
+							rows[count] = i;
+							columns[count] = j;
+							rngs[count] = accumulation.rngs[index];
+							colors[count] = vec3( 0.0f );
+							count++;
 						}
 					}
-					// color average
-					color /= ( config.antialiasing_samples * config.dof_samples );
+
+					trace_sample_packet( scene, config, rows, columns, count, pass, rngs, colors );
+
+					for ( unsigned p = 0u; p < count; p++ )
+					{
+						const size_t index = static_cast<size_t>( rows[p] ) * config.width + columns[p];
+						accumulation.rngs[index] = rngs[p];
+						add_sample( accumulation, index, colors[p] );
+					}
 				}
+			}
+		}
 
-				color = clamp( color, { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } );
+		else
+		{
+			for ( int i = tile.y; i < tile.y + tile.height; i++ )
+			{
+				for ( int j = tile.x; j < tile.x + tile.width; j++ )
+				{
+					const size_t index = static_cast<size_t>( i ) * config.width + j;
+					add_sample( accumulation, index, trace_sample( scene, config, i, j, pass, accumulation.rngs[index] ) );
+				}
+			}
+		}
 
-				// transform the color buffer from float to char
-				color_buffer[( i * config.width + j ) * 3]		= static_cast<char>( color.x * 255.99f );
-				color_buffer[( i * config.width + j ) * 3 + 1]	= static_cast<char>( color.y * 255.99f );
-				color_buffer[( i * config.width + j ) * 3 + 2]	= static_cast<char>( color.z * 255.99f );
+		// average of the samples so far
+		for ( int i = tile.y; i < tile.y + tile.height; i++ )
+		{
+			for ( int j = tile.x; j < tile.x + tile.width; j++ )
+			{
+				const size_t index = static_cast<size_t>( i ) * config.width + j;
+				write_pixel( color_buffer, config, i, j, accumulation.color[index] / static_cast<float>( accumulation.samples[index] ) );
+			}
+		}
+	}
 
-				if ( *terminate == true )
-					return; 
+	/**
+	* @brief add one sample to the selected pixels of a tile and update their color
+	*
+	* The selected pixels are scattered, so the camera rays are not traced as packets.
+	* @param accumulation		sums of the samples of every pixel
+	* @param color_buffer		result color buffer in chars
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param tile				pixels to compute
+	* @param noisy				flag of every pixel of the image, set for the ones to sample
+	*/
+	void trace_tile_noisy( Accumulation& accumulation, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, const Tile& tile, const std::vector<char>& noisy )
+	{
+		for ( int i = tile.y; i < tile.y + tile.height; i++ )
+		{
+			for ( int j = tile.x; j < tile.x + tile.width; j++ )
+			{
+				const size_t index = static_cast<size_t>( i ) * config.width + j;
+				if ( noisy[index] == 0 )
+					continue;
+
+				// the samples past the supersampling grid are jittered inside the pixel
+				const int sample = static_cast<int>( accumulation.samples[index] );
+				add_sample( accumulation, index, trace_sample( scene, config, i, j, sample, accumulation.rngs[index] ) );
+				write_pixel( color_buffer, config, i, j, accumulation.color[index] / static_cast<float>( accumulation.samples[index] ) );
 			}
 		}
 	}
 
 	/**
-	* @brief compute the pixel color using adaptive antialiasing
-	* @param scene
-	* @param config
-	* @param center				center of the color
-	* @param sample_offset_x	offset in x for the subdivision
-	* @param sample_offset_y	offset in y for the subdivision
-	* @param depth
+	* @brief add a sample to the sums of a pixel
+	* @param accumulation		sums of the samples of every pixel
+	* @param index				pixel
+	* @param color				color of the sample (not clamped)
 	*/
-	vec3 adaptive_sampling( const Scene& scene, const Configuration& config, const vec3 center, const vec3 sample_offset_x, const vec3 sample_offset_y, const int depth )
+	void add_sample( Accumulation& accumulation, const size_t index, const vec3& color )
 	{
-		const float tolerance = 0.05f;
-		const Camera& camera = scene.camera();
+		// the variance is measured on the displayed value
+		const float luminance = display_luminance( color );
+
+		accumulation.color[index] += color;
+		accumulation.luminance[index] += luminance;
+		accumulation.squared[index] += luminance * luminance;
+		accumulation.samples[index]++;
+	}
+
+	/**
+	* @brief get the brightness of a color as shown in the image
+	* @param color				color (not clamped)
+	* @return luminance of the clamped color
+	*/
+	float display_luminance( const vec3& color )
+	{
+		return dot( clamp( color, vec3( 0.0f ), vec3( 1.0f ) ), vec3( 0.2126f, 0.7152f, 0.0722f ) );
+	}
+
+	/**
+	* @brief select the pixels getting a sample in the next round of a time limited render
+	* @param accumulation		sums of the samples of every pixel
+	* @param noisy				flag of every pixel of the image (return)
+	* @return false if no pixel has any noise left
+	*/
+	bool select_noisy_pixels( const Accumulation& accumulation, std::vector<char>& noisy )
+	{
+		const size_t pixel_count = accumulation.samples.size();
+
+		// standard error of the mean luminance, unknown (infinite) with a single sample
+		std::vector<float> errors( pixel_count );
+		for ( size_t i = 0u; i < pixel_count; i++ )
+		{
+			const float n = static_cast<float>( accumulation.samples[i] );
+			if ( n < 2.0f )
+			{
+				errors[i] = std::numeric_limits<float>::max();
+				continue;
+			}
+
+			// both moments of the clamped samples, the clamped mean would hide the fireflies
+			const float mean = accumulation.luminance[i] / n;
+			const float variance = std::max( accumulation.squared[i] / n - mean * mean, 0.0f ) * n / ( n - 1.0f );
+			errors[i] = std::sqrt( variance / n );
+		}
+
+		// the quarter of the pixels with the highest error
+		std::vector<float> sorted = errors;
+		auto quartile = sorted.begin() + pixel_count * 3u / 4u;
+		std::nth_element( sorted.begin(), quartile, sorted.end() );
+		const float threshold = *quartile;
+
+		bool any = false;
+		for ( size_t i = 0u; i < pixel_count; i++ )
+		{
+			noisy[i] = errors[i] > 0.0f && errors[i] >= threshold;
+			any = any || noisy[i];
+		}
+
+		return any;
+	}
+
+	/**
+	* @brief print the amount of samples of each region of the image (8x8 regions at most)
+	* @param accumulation		sums of the samples of every pixel
+	* @param config				raytracer values
+	* @param seconds			render time
+	*/
+	void report_samples( const Accumulation& accumulation, const Configuration& config, const double seconds )
+	{
+		const int columns = std::min( config.width, 8 );
+		const int rows = std::min( config.height, 8 );
+
+		std::vector<double>	sums( columns * rows, 0.0 );
+		std::vector<int>	pixels( columns * rows, 0 );
+		double total = 0.0;
+
+		for ( int i = 0; i < config.height; i++ )
+		{
+			for ( int j = 0; j < config.width; j++ )
+			{
+				const unsigned samples = accumulation.samples[static_cast<size_t>( i ) * config.width + j];
+				const int region = i * rows / config.height * columns + j * columns / config.width;
+				sums[region] += samples;
+				pixels[region]++;
+				total += samples;
+			}
+		}
+
+		std::cout << "Rendered " << seconds << " s of " << config.time_limit << " s, "
+				  << total / ( static_cast<double>( config.width ) * config.height ) << " samples per pixel on average" << std::endl;
+		std::cout << "Samples per pixel of each region:" << std::endl;
+
+		for ( int y = 0; y < rows; y++ )
+		{
+			for ( int x = 0; x < columns; x++ )
+				std::cout << "\t" << static_cast<int>( sums[y * columns + x] / pixels[y * columns + x] + 0.5 );
+			std::cout << std::endl;
+		}
+	}
+
+	/**
+	* @brief compute the color value of a pixel
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param i					row of the pixel
+	* @param j					column of the pixel
+	* @return color (not clamped)
+	*/
+	vec3 trace_pixel( const CompiledScene& scene, const Configuration& config, const int i, const int j )
+	{
+		vec3 color( 0.0f );
+
+		// every pixel draws from its own sequence so the image does not depend on the threads
+		Random rng( config.seed, static_cast<uint64_t>( i ) * config.width + j );
+
+		// supersampling antialiasing
+		const int samples = pixel_samples( config );
+
+		for ( int sample = 0; sample < samples; sample++ )
+			color += trace_sample( scene, config, i, j, sample, rng );
+
+		// color average
+		return color / static_cast<float>( config.antialiasing_samples * config.dof_samples );
+	}
+
+	/**
+	* @brief compute the color seen by one of the camera rays of a pixel
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param i					row of the pixel
+	* @param j					column of the pixel
+	* @param sample				index of the sample: supersampling row, column and dof sample
+	* @param rng				random generator of the pixel
+	* @return color (not clamped)
+	*/
+	vec3 trace_sample( const CompiledScene& scene, const Configuration& config, const int i, const int j, const int sample, Random& rng )
+	{
+		Sampler sampler( config.sampler, config.seed, i, j, rng );
+		sampler.start( sample, pixel_samples( config ) );
+
+		Shapes::Ray ray = compute_camera_ray( scene.camera(), config, i, j, sample, sampler );
+
+		// compute the value of the pixel
+		return compute_pixel( scene, ray, config, sampler, scene.air().electric_permitivity, scene.air().magnetic_permeability );
+	}
+
+	/**
+	* @brief add the same sample of a block of pixels, the camera rays are traced as a packet
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param rows				row of each pixel
+	* @param columns			column of each pixel
+	* @param count				amount of pixels (up to the packet width)
+	* @param sample				index of the sample: supersampling row, column and dof sample
+	* @param rngs				random generator of each pixel
+	* @param colors				color of each pixel, the sample is added (return)
+	*/
+	void trace_sample_packet( const CompiledScene& scene, const Configuration& config, const int* rows, const int* columns, const unsigned count, const int sample, Random* rngs, vec3* colors )
+	{
+		const Lights::Air& air = scene.air();
+
+		Sampler samplers[Packets::max_width];
+
+		Packets::RayPacket packet;
+		for ( unsigned p = 0u; p < count; p++ )
+		{
+			samplers[p] = Sampler( config.sampler, config.seed, rows[p], columns[p], rngs[p] );
+			samplers[p].start( sample, pixel_samples( config ) );
+			packet.add( compute_camera_ray( scene.camera(), config, rows[p], columns[p], sample, samplers[p] ) );
+		}
+
+		Intersection::Hit hits[Packets::max_width];
+		scene.intersect_packet( packet, hits );
+
+		for ( unsigned p = 0u; p < count; p++ )
+		{
+			if ( config.depth > 0 && hits[p].time != -1.0f )
+				colors[p] += shade_contact( scene, packet.rays[p], scene.contact( packet.rays[p], hits[p] ), config, samplers[p], air.electric_permitivity, air.magnetic_permeability, 0 );
+		}
+	}
+
+	/**
+	* @brief store the color of a pixel in the output buffer
+	* @param color_buffer		result color buffer in chars
+	* @param config				raytracer values
+	* @param i					row of the pixel
+	* @param j					column of the pixel
+	* @param color				color of the pixel, clamped to [0, 1]
+	*/
+	void write_pixel( std::vector<unsigned char>& color_buffer, const Configuration& config, const int i, const int j, vec3 color )
+	{
+		color = clamp( color, { 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f } );
+
+		// transform the color buffer from float to char
+		const size_t index = ( static_cast<size_t>( i ) * config.width + j ) * 3u;
+		color_buffer[index]		= static_cast<char>( color.x * 255.99f );
+		color_buffer[index + 1]	= static_cast<char>( color.y * 255.99f );
+		color_buffer[index + 2]	= static_cast<char>( color.z * 255.99f );
+	}
+
+	/**
+	* @brief get the amount of camera rays of each pixel with supersampling
+	* @param config				raytracer values
+	* @return supersampling grid times the dof samples
+	*/
+	int pixel_samples( const Configuration& config )
+	{
+		const int pixel_size = static_cast<int>( sqrt( config.antialiasing_samples ) );
+		return pixel_size * pixel_size * config.dof_samples;
+	}
 
-		// get position of the samples
-		const vec3 pos[4] = {
-			center - sample_offset_x + sample_offset_y,
-			center + sample_offset_x + sample_offset_y,
-			center - sample_offset_x - sample_offset_y,
-			center + sample_offset_x - sample_offset_y
+	/**
+	* @brief compute one of the camera rays of a pixel
+	* @param camera
+	* @param config				raytracer values
+	* @param i					row of the pixel
+	* @param j					column of the pixel
+	* @param sample				index of the sample: supersampling row, column and dof sample
+	* @param sampler			values of the sample
+	* @return ray
+	*/
+	Shapes::Ray compute_camera_ray( const Camera& camera, const Configuration& config, const int i, const int j, const int sample, Sampler& sampler )
+	{
+		const float half_width  = static_cast<float>( config.width ) / 2.0f;
+		const float half_height = static_cast<float>( config.height ) / 2.0f;
+
+		const int pixel_size = static_cast<int>( sqrt( config.antialiasing_samples ) );
+		const float half_pixel_size = static_cast<float>( pixel_size ) / 2.0f;
+		const vec3  half_pixel_width  = camera.u / static_cast<float>( config.width ) / 2.0f;
+		const vec3  half_pixel_height = camera.v / static_cast<float>( config.height ) / 2.0f;
+
+		// supersampling row, column and dof sample
+		const int m = sample % config.dof_samples;
+		const int l = ( sample / config.dof_samples ) % pixel_size;
+		const int k = sample / ( config.dof_samples * pixel_size );
+
+		// compute the y value for the current row
+		vec3 y = ( static_cast<float>( i ) - half_height + 0.5f ) / half_height * camera.v;
+
+		// compute the x value for the current column
+		vec3 x = ( static_cast<float>( j ) - half_width + 0.5f ) / half_width * camera.u;
+
+		// add offset inside pixel, the samples past the grid (time limited renders) are jittered
+		vec3 pixel_y = ( static_cast<float>( k ) - half_pixel_size + 0.5f ) / half_pixel_size * half_pixel_height;
+		vec3 pixel_x = ( static_cast<float>( l ) - half_pixel_size + 0.5f ) / half_pixel_size * half_pixel_width;
+
+		// the grid is already stratified, the sampler places the samples past it
+		const unsigned dimension = sampler.next_dimension();
+		if ( k >= pixel_size )
+		{
+			const vec2 offset = sampler.get_2d( dimension ) * 2.0f - 1.0f;
+			pixel_y = offset.x * half_pixel_height;
+			pixel_x = offset.y * half_pixel_width;
+		}
+
+		// create the ray for the current pixel
+		vec3 pixel_pos = x + pixel_x - y - pixel_y + camera.center;
+
+		if ( m == 0 )
+			return Shapes::Ray( camera.pos, normalize( pixel_pos - camera.pos ) );
+
+		// spherical aberration
+		vec2 axis_offset = {
+			( static_cast<float>( j ) - half_width  + 0.5f ) / half_width,
+			( static_cast<float>( i ) - half_height + 0.5f ) / half_height
 		};
+		float axis_dist = sqrt( axis_offset.x * axis_offset.x + axis_offset.y * axis_offset.y ) * camera.aperture;
+		float focal_point = compute_focal_point( camera, axis_dist );
+
+		return compute_ray_dir_dof( camera, pixel_pos, focal_point, sampler );
+	}
+
+	/**
+	* @brief sample the image adaptively on a lattice shared by all the pixels
+	*
+	* Every pixel starts with the rays through its 4 corners, which are shared with its neighbours,
+	* so the first level costs about one ray per pixel. A pixel whose corners have a standard error
+	* of the luminance above the threshold is split in 2x2 cells, adding the rays through the new
+	* corners, again shared with the neighbours refined as far. The levels are limited by the
+	* antialiasing samples (16 samples -> 4x4 cells). The color is the average of the cells, each
+	* one the average of its corners.
+	* @param colors				color of every pixel (return)
+	* @param color_buffer		result color buffer in chars, updated after every level
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param terminate			flag to stop rendering
+	* @param preview			front end to show the image while rendering (nullptr for none)
+	*/
+	void trace_adaptive( std::vector<vec3>& colors, std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview )
+	{
+		const size_t pixel_count = static_cast<size_t>( config.width ) * config.height;
 
-		Shapes::Ray rays[4];
-		vec3 colors[4];
-		vec3 final_color( 0.0f );
+		// 4^level cells at most per pixel
+		int max_level = 0;
+		while ( 1 << ( 2 * ( max_level + 1 ) ) <= config.antialiasing_samples )
+			max_level++;
 
-		// compute the rays and colors
-		for ( int i = 0; i < 4; i++ )
+		colors.assign( pixel_count, vec3( 0.0f ) );
+		std::vector<int> levels( pixel_count, 0 );
+		std::vector<size_t> level_pixels;
+		std::atomic<size_t> rays( 0u );
+
+		LatticeLevel coarse;
+		LatticeLevel lattice;
+
+		for ( int level = 0; level <= max_level && terminate == false; level++ )
 		{
-			rays[i]		= Shapes::Ray( camera.pos, normalize( pos[i] - camera.pos ) );
-			colors[i]	= compute_pixel( scene, rays[i], config, scene.air().electric_permitivity, scene.air().magnetic_permeability );
-			final_color += colors[i];
+			build_lattice_level( lattice, levels, config, level );
+			if ( lattice.colors.empty() )
+				break;
+
+			trace_tiles( config, [&]( const Tile& tile )
+			{
+				trace_lattice_tile( lattice, coarse, levels, scene, config, tile, level, max_level, rays );
+			}, terminate, preview, color_buffer );
+
+			if ( terminate == true )
+				break;
+
+			level_pixels.push_back( static_cast<size_t>( std::count( levels.begin(), levels.end(), level ) ) );
+
+			trace_tiles( config, [&]( const Tile& tile )
+			{
+				resolve_lattice_tile( colors, levels, color_buffer, lattice, config, tile, level, max_level );
+			}, terminate, preview, color_buffer );
+
+			std::swap( coarse, lattice );
 		}
 
-		// get average of color
-		final_color /= 4.0f;
+		std::cout << "Adaptive sampling: " << static_cast<double>( rays ) / pixel_count << " camera rays per pixel ("
+				  << ( ( 1 << max_level ) + 1 ) * ( ( 1 << max_level ) + 1 ) << " at most), pixels per level:";
+		for ( size_t count : level_pixels )
+			std::cout << " " << count;
+		std::cout << std::endl;
+	}
 
-		//return final_color;
+	/**
+	* @brief allocate the points of a level of the adaptive lattice
+	* @param lattice			level to build
+	* @param levels				level reached by every pixel
+	* @param config				raytracer values
+	* @param level
+	*/
+	void build_lattice_level( LatticeLevel& lattice, const std::vector<int>& levels, const Configuration& config, const int level )
+	{
+		const size_t owner_count = static_cast<size_t>( config.width + 1 ) * ( config.height + 1 );
+
+		lattice.cells = 1 << level;
+		lattice.offsets.resize( owner_count + 1u );
 
-		// if maximum depth was not reached
-		if ( depth < config.antialiasing_samples )
+		// an owner keeps its points if one of the pixels sharing its corner reaches the level
+		size_t offset = 0u;
+		for ( int y = 0; y <= config.height; y++ )
 		{
-			// modify colors if they do not meet the tolerance
-			for ( int i = 0; i < 4; i++ )
+			for ( int x = 0; x <= config.width; x++ )
 			{
-				if ( std::abs( ( colors[i] - final_color ).length() ) > tolerance )
-					colors[i] = adaptive_sampling( scene, config, pos[i], sample_offset_x / 2.0f, sample_offset_y / 2.0f, depth + 1 );
+				lattice.offsets[static_cast<size_t>( y ) * ( config.width + 1 ) + x] = offset;
+				if ( lattice_point_needed( levels, config, x, y, 0, 0, level ) )
+					offset += static_cast<size_t>( lattice.cells ) * lattice.cells;
 			}
+		}
+		lattice.offsets[owner_count] = offset;
+
+		lattice.colors.assign( offset, vec3( 0.0f ) );
+	}
+
+	/**
+	* @brief trace the points of a level of the adaptive lattice owned by the pixels of a tile
+	* @param lattice			level to fill
+	* @param coarse				previous level, its points are copied
+	* @param levels				level reached by every pixel
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param tile				pixels owning the points (the right and bottom border own one more column / row)
+	* @param level
+	* @param max_level			finest level, the position in it gives the random sequence of the point
+	* @param rays				amount of rays traced (return)
+	*/
+	void trace_lattice_tile( LatticeLevel& lattice, const LatticeLevel& coarse, const std::vector<int>& levels, const CompiledScene& scene, const Configuration& config, const Tile& tile, const int level, const int max_level, std::atomic<size_t>& rays )
+	{
+		const Camera& camera = scene.camera();
+		const Lights::Air& air = scene.air();
 
-			// recompute the final color
-			final_color = vec3( 0.0f );
-			for ( int i = 0; i < 4; i++ )
-				final_color += colors[i];
-			final_color /= 4.0f;
+		const float half_width  = static_cast<float>( config.width ) / 2.0f;
+		const float half_height = static_cast<float>( config.height ) / 2.0f;
+
+		const int cells = lattice.cells;
+		const int scale = 1 << ( max_level - level );
+		const uint64_t first_sequence = static_cast<uint64_t>( config.width ) * config.height;
+		const uint64_t lattice_width = ( static_cast<uint64_t>( config.width ) << max_level ) + 1u;
+
+		const int end_x = tile.x + tile.width + ( tile.x + tile.width == config.width ? 1 : 0 );
+		const int end_y = tile.y + tile.height + ( tile.y + tile.height == config.height ? 1 : 0 );
+
+		size_t traced = 0u;
+		for ( int y = tile.y; y < end_y; y++ )
+		{
+			for ( int x = tile.x; x < end_x; x++ )
+			{
+				const size_t owner = static_cast<size_t>( y ) * ( config.width + 1 ) + x;
+				if ( lattice.offsets[owner] == lattice.offsets[owner + 1u] )
+					continue;
+
+				for ( int b = 0; b < cells; b++ )
+				{
+					for ( int a = 0; a < cells; a++ )
+					{
+						if ( lattice_point_needed( levels, config, x, y, a, b, level ) == false )
+							continue;
+
+						vec3& color = lattice.colors[lattice.offsets[owner] + b * cells + a];
+
+						// corners of the previous level
+						if ( level > 0 && a % 2 == 0 && b % 2 == 0 )
+						{
+							color = coarse.colors[coarse.offsets[owner] + ( b / 2 ) * coarse.cells + a / 2];
+							continue;
+						}
+
+						// position in pixels
+						const float u = static_cast<float>( x ) + static_cast<float>( a ) / cells;
+						const float v = static_cast<float>( y ) + static_cast<float>( b ) / cells;
+						vec3 pixel_pos = ( u - half_width ) / half_width * camera.u - ( v - half_height ) / half_height * camera.v + camera.center;
+
+						// every point draws from its own sequence, after the ones of the pixels
+						const uint64_t point = ( static_cast<uint64_t>( y ) * cells + b ) * scale * lattice_width + ( static_cast<uint64_t>( x ) * cells + a ) * scale;
+						Random rng( config.seed, first_sequence + point );
+
+						// the lattice already spreads the points over the pixel, the shading draws from the sequence
+						Sampler sampler( Samplers::Type::random, config.seed, y, x, rng );
+
+						Shapes::Ray ray( camera.pos, normalize( pixel_pos - camera.pos ) );
+						color = compute_pixel( scene, ray, config, sampler, air.electric_permitivity, air.magnetic_permeability );
+						traced++;
+					}
+				}
+			}
 		}
 
-		return final_color;
+		rays += traced;
+	}
+
+	/**
+	* @brief compute the color of the pixels of a tile that reached a level, and refine the noisy ones
+	* @param colors				color of every pixel (return)
+	* @param levels				level reached by every pixel, increased for the pixels to refine
+	* @param color_buffer		result color buffer in chars
+	* @param lattice			points of the level
+	* @param config				raytracer values
+	* @param tile				pixels to compute
+	* @param level
+	* @param max_level			finest level
+	*/
+	void resolve_lattice_tile( std::vector<vec3>& colors, std::vector<int>& levels, std::vector<unsigned char>& color_buffer, const LatticeLevel& lattice, const Configuration& config, const Tile& tile, const int level, const int max_level )
+	{
+		const int cells = lattice.cells;
+
+		for ( int i = tile.y; i < tile.y + tile.height; i++ )
+		{
+			for ( int j = tile.x; j < tile.x + tile.width; j++ )
+			{
+				const size_t index = static_cast<size_t>( i ) * config.width + j;
+				if ( levels[index] != level )
+					continue;
+
+				// average of the cells: the border points are shared by 2 cells and the pixel corners by 4
+				vec3 color( 0.0f );
+				float luminance = 0.0f;
+				float squared = 0.0f;
+				for ( int b = 0; b <= cells; b++ )
+				{
+					for ( int a = 0; a <= cells; a++ )
+					{
+						const vec3& point = lattice_color( lattice, config, i, j, a, b );
+						const float weight = ( a == 0 || a == cells ? 0.5f : 1.0f ) * ( b == 0 || b == cells ? 0.5f : 1.0f );
+						color += point * weight;
+
+						const float point_luminance = display_luminance( point );
+						luminance += point_luminance;
+						squared += point_luminance * point_luminance;
+					}
+				}
+				color /= static_cast<float>( cells * cells );
+
+				colors[index] = color;
+				write_pixel( color_buffer, config, i, j, color );
+
+				// standard error of the luminance of the points
+				const float n = static_cast<float>( ( cells + 1 ) * ( cells + 1 ) );
+				const float mean = luminance / n;
+				const float variance = std::max( squared / n - mean * mean, 0.0f ) * n / ( n - 1.0f );
+
+				if ( level < max_level && std::sqrt( variance / n ) > config.adaptive_threshold )
+					levels[index] = level + 1;
+			}
+		}
+	}
+
+	/**
+	* @brief check if a point of the adaptive lattice is used by a pixel that reached a level
+	* @param levels				level reached by every pixel
+	* @param config				raytracer values
+	* @param x					column of the owner
+	* @param y					row of the owner
+	* @param a					column of the point in the owner
+	* @param b					row of the point in the owner
+	* @param level
+	* @return true if the point has to be computed
+	*/
+	bool lattice_point_needed( const std::vector<int>& levels, const Configuration& config, const int x, const int y, const int a, const int b, const int level )
+	{
+		auto reaches = [&]( const int column, const int row )
+		{
+			return column >= 0 && row >= 0 && column < config.width && row < config.height && levels[static_cast<size_t>( row ) * config.width + column] >= level;
+		};
+
+		// the left column and top row are shared with the pixels to the left and above
+		return reaches( x, y ) || ( a == 0 && reaches( x - 1, y ) ) || ( b == 0 && reaches( x, y - 1 ) ) || ( a == 0 && b == 0 && reaches( x - 1, y - 1 ) );
+	}
+
+	/**
+	* @brief get a point of a pixel from the adaptive lattice
+	* @param lattice			points of the level
+	* @param config				raytracer values
+	* @param i					row of the pixel
+	* @param j					column of the pixel
+	* @param a					column of the point in the pixel [0, cells]
+	* @param b					row of the point in the pixel [0, cells]
+	* @return color
+	*/
+	const vec3& lattice_color( const LatticeLevel& lattice, const Configuration& config, const int i, const int j, const int a, const int b )
+	{
+		// the right column and bottom row belong to the next pixels
+		const int x = j + a / lattice.cells;
+		const int y = i + b / lattice.cells;
+		const size_t owner = static_cast<size_t>( y ) * ( config.width + 1 ) + x;
+
+		return lattice.colors[lattice.offsets[owner] + ( b % lattice.cells ) * lattice.cells + a % lattice.cells];
 	}
 
 	/**
@@ -258,20 +1094,100 @@ namespace Raytracer
 	* @param scene	scene to trace
 	* @param ray	ray from the camera equivalent for the current pixel
 	* @param config	raytracer values
+	* @param sampler	values of the camera sample
 	* @param depth	current level of recursion
+	* @param throughput	fraction of the light of the ray that reaches the camera (russian roulette of path tracing)
 	*/
-	vec3 compute_pixel( const Scene& scene, const Shapes::Ray& ray, const Configuration& config, const float e_permittivity, const float m_permeability, const int depth )
+	vec3 compute_pixel( const CompiledScene& scene, const Shapes::Ray& ray, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth, const float throughput )
 	{
 		if ( config.depth <= depth )
 			return vec3{ 0.0f, 0.0f, 0.0f };
 
-		// get the contact of raycasting against the scene
-		auto contact = raycast_scene( scene, ray );
+		// get the closest hit of raycasting against the scene
+		Intersection::Hit hit;
 
 		// if no contact return black
-		if ( contact.time == -1.0f )
+		if ( scene.intersect( ray, hit ) == false )
 			return vec3( 0.0f, 0.0f, 0.0f );
 
+		return shade_contact( scene, ray, scene.contact( ray, hit ), config, sampler, e_permittivity, m_permeability, depth, throughput );
+	}
+
+	/**
+	* @brief compute the color seen by a ray that hit the scene
+	*
+	* The reflected and refracted rays are traced without recursion: every contact being shaded
+	* has a frame in a per thread stack, the top one spawns its next ray and is resumed with its
+	* color. The rays are spawned in the same order as a recursive tracer, so the random numbers
+	* and the image are the same.
+	* @param scene			scene to trace
+	* @param ray			ray that hit the scene
+	* @param contact		closest contact of the ray
+	* @param config			raytracer values
+	* @param sampler		values of the camera sample
+	* @param e_permittivity	electric permittivity of the medium the ray travels through
+	* @param m_permeability	magnetic permeability of the medium the ray travels through
+	* @param depth			current level of recursion
+	* @param throughput		fraction of the light of the ray that reaches the camera (russian roulette of path tracing)
+	*/
+	vec3 shade_contact( const CompiledScene& scene, const Shapes::Ray& ray, const Intersection::Contact& contact, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth, const float throughput )
+	{
+		// one frame per level below the first contact at most
+		thread_local std::vector<ShadeFrame> stack;
+		if ( stack.size() < static_cast<size_t>( std::max( config.depth - depth, 1 ) ) )
+			stack.resize( std::max( config.depth - depth, 1 ) );
+
+		size_t top = 0u;
+		begin_shading( stack[top], scene, ray, contact, config, sampler, e_permittivity, m_permeability, depth, throughput );
+
+		while ( true )
+		{
+			ShadeFrame& frame = stack[top];
+
+			Shapes::Ray next_ray;
+			float next_e_permittivity;
+			float next_m_permeability;
+			float next_throughput;
+
+			// all the rays of the contact are done, give its color to the contact that spawned it
+			if ( spawn_ray( frame, sampler, next_ray, next_e_permittivity, next_m_permeability, next_throughput ) == false )
+			{
+				vec3 color = end_shading( frame );
+				if ( top == 0u )
+					return color;
+
+				add_ray_color( stack[--top], color );
+				continue;
+			}
+
+			// past the maximum depth or no contact -> black
+			Intersection::Hit hit;
+			if ( config.depth <= frame.depth + 1 || scene.intersect( next_ray, hit ) == false )
+			{
+				add_ray_color( frame, vec3( 0.0f ) );
+				continue;
+			}
+
+			top++;
+			begin_shading( stack[top], scene, next_ray, scene.contact( next_ray, hit ), config, sampler, next_e_permittivity, next_m_permeability, frame.depth + 1, next_throughput );
+		}
+	}
+
+	/**
+	* @brief start shading a contact: medium, fresnel coefficients, direct light and rays to spawn
+	* @param frame			state of the contact (return)
+	* @param scene			scene to trace
+	* @param ray			ray that hit the scene
+	* @param contact		closest contact of the ray
+	* @param config			raytracer values
+	* @param sampler		values of the camera sample
+	* @param e_permittivity	electric permittivity of the medium the ray travels through
+	* @param m_permeability	magnetic permeability of the medium the ray travels through
+	* @param depth			current level of recursion
+	* @param throughput		fraction of the light of the ray that reaches the camera
+	*/
+	void begin_shading( ShadeFrame& frame, const CompiledScene& scene, const Shapes::Ray& ray, const Intersection::Contact& contact, const Configuration& config, Sampler& sampler, const float e_permittivity, const float m_permeability, const int depth, const float throughput )
+	{
 
 		// electric permitivity and magnetic permeability
 		float next_e_permittivity;
@@ -313,101 +1229,231 @@ namespace Raytracer
 
 
 		// lighting for absorbed light
-		vec3 color = absortion * raycast_lights( scene, ray, config.shadow_samples, contact_point_out, contact.normal, contact.material );
-
+		frame.color = absortion * raycast_lights( scene, ray, sampler, config.shadow_samples, config.shadow_min_samples, contact_point_out, contact.normal, contact.material );
+		frame.reflection_color = vec3( 0.0f );
 
-
-		// refracted color
-		if ( transmission > 0.0f )
+		// air attenuation
+		auto& air = scene.air();
+		float traversed_dist = length( contact.point - ray.pos );
+		frame.attenuation = glm::pow( air.attenuation, vec3( traversed_dist ) );
+		frame.throughput = throughput * std::max( frame.attenuation.x, std::max( frame.attenuation.y, frame.attenuation.z ) );
+
+		frame.ray = ray;
+		frame.normal = N;
+		frame.contact_point_out = contact_point_out;
+		frame.contact_point_in = contact_point_in;
+		frame.e_permittivity = e_permittivity;
+		frame.m_permeability = m_permeability;
+		frame.next_e_permittivity = next_e_permittivity;
+		frame.next_m_permeability = next_m_permeability;
+		frame.reflection = reflection;
+		frame.transmission = transmission;
+		frame.roughness = contact.material.roughness;
+		frame.depth = depth;
+
+		// if roughness is zero all samples will go in the same direction
+		frame.samples = contact.material.roughness == 0.0f ? 1 : config.reflection_samples;
+		frame.next = 0;
+		frame.reflection_dimension = sampler.next_dimension( 1u );
+		frame.path = config.path_tracing == true && depth > 0;
+		frame.path_ray = ShadeFrame::PathRay::none;
+
+		// path tracing: past the first bounce only one of the rays is followed, picked with the weight of
+		// each branch, so the cost grows linearly with the depth instead of (1 + reflection samples)^depth
+		if ( frame.path == true )
 		{
-			// coefficients of refraction
-			float n_i = sqrt( e_permittivity * m_permeability );
-			float n_t = sqrt( next_e_permittivity * next_m_permeability );
-			float ior = n_i / n_t;
+			const float weight = reflection + transmission;
 
-			vec3 refr_dir = glm::refract( I, N, ior );
+			// russian roulette, the paths carrying little light stop early and the others carry more
+			const float survival = std::min( frame.throughput * weight, 1.0f );
+			if ( weight > 0.0f && sampler.next_float() < survival )
+			{
+				frame.scale = weight / survival;
 
-			Shapes::Ray refr_ray( contact_point_in, normalize( refr_dir ) );
-			color += transmission * compute_pixel( scene, refr_ray, config, next_e_permittivity, next_m_permeability, depth + 1u );
+				if ( sampler.next_float() * weight < transmission )
+					frame.path_ray = ShadeFrame::PathRay::refraction;
 
+				// the mirror direction is one of the reflection samples
+				else if ( sampler.next_float() * static_cast<float>( frame.samples ) < 1.0f )
+					frame.path_ray = ShadeFrame::PathRay::mirror;
+				else
+					frame.path_ray = ShadeFrame::PathRay::rough;
+			}
 		}
+	}
 
-
-
-		// reflected color
-		if ( reflection > 0.0f )
+	/**
+	* @brief get the next ray to trace from a contact
+	* @param frame				state of the contact
+	* @param sampler			values of the camera sample
+	* @param ray				ray to trace (return)
+	* @param e_permittivity		electric permittivity of the medium of the ray (return)
+	* @param m_permeability		magnetic permeability of the medium of the ray (return)
+	* @param throughput			fraction of the light of the ray that reaches the camera (return)
+	* @return false if the contact has no rays left
+	*/
+	bool spawn_ray( ShadeFrame& frame, Sampler& sampler, Shapes::Ray& ray, float& e_permittivity, float& m_permeability, float& throughput )
+	{
+		if ( frame.path == true )
 		{
-			vec3 reflection_ray = glm::reflect( ray.dir, N );
-			vec3 reflection_color(0.0f);
+			if ( frame.next > 0 || frame.path_ray == ShadeFrame::PathRay::none )
+				return false;
 
-			// if roughness is zero all samples will go in the same direction
-			int samples = contact.material.roughness == 0.0f ? 1 : config.reflection_samples;
+			frame.next++;
+			throughput = frame.throughput * frame.scale;
 
-			for ( int i = 0; i < samples; i++ )
+			if ( frame.path_ray == ShadeFrame::PathRay::refraction )
 			{
-				// compute reflection direction
-				vec3 reflection_dir;
-				if ( i == 0 )
-					reflection_dir = contact_point_out + reflection_ray;
-				else
-					reflection_dir = get_random_sample( contact_point_out + reflection_ray, contact.material.roughness );
+				ray = refraction_ray( frame.ray, frame.normal, frame.contact_point_in, frame.e_permittivity, frame.m_permeability, frame.next_e_permittivity, frame.next_m_permeability );
+				e_permittivity = frame.next_e_permittivity;
+				m_permeability = frame.next_m_permeability;
+			}
+			else
+			{
+				ray = reflection_ray( frame.ray, frame.normal, frame.contact_point_out, frame.roughness, frame.path_ray == ShadeFrame::PathRay::mirror, sampler, frame.reflection_dimension, 0u, 1u );
+				e_permittivity = frame.e_permittivity;
+				m_permeability = frame.m_permeability;
+			}
+			return true;
+		}
 
-				// compute reflection color
-				Shapes::Ray new_ray( contact_point_out, normalize( reflection_dir - contact_point_out ) );
-				reflection_color += reflection * compute_pixel( scene, new_ray, config, e_permittivity, m_permeability, depth + 1 );
+		// refracted ray first
+		if ( frame.next == 0 )
+		{
+			frame.next++;
+			if ( frame.transmission > 0.0f )
+			{
+				ray = refraction_ray( frame.ray, frame.normal, frame.contact_point_in, frame.e_permittivity, frame.m_permeability, frame.next_e_permittivity, frame.next_m_permeability );
+				e_permittivity = frame.next_e_permittivity;
+				m_permeability = frame.next_m_permeability;
+				throughput = frame.throughput * frame.transmission;
+				return true;
 			}
+		}
 
-			// normalize reflection color and add it to the result
-			reflection_color = reflection_color / static_cast<float>( samples );
-			color += reflection_color;
+		// then the reflection samples, the first one in the mirror direction and the rough ones drawn together
+		if ( frame.reflection > 0.0f && frame.next <= frame.samples )
+		{
+			const unsigned rough_sample = static_cast<unsigned>( std::max( frame.next - 2, 0 ) );
+			ray = reflection_ray( frame.ray, frame.normal, frame.contact_point_out, frame.roughness, frame.next == 1, sampler, frame.reflection_dimension, rough_sample, static_cast<unsigned>( std::max( frame.samples - 1, 1 ) ) );
+			e_permittivity = frame.e_permittivity;
+			m_permeability = frame.m_permeability;
+			throughput = frame.throughput * frame.reflection / static_cast<float>( frame.samples );
+			frame.next++;
+			return true;
 		}
 
+		return false;
+	}
 
+	/**
+	* @brief add the color seen by the last ray spawned from a contact
+	* @param frame				state of the contact
+	* @param color				color of the ray (not weighted)
+	*/
+	void add_ray_color( ShadeFrame& frame, const vec3& color )
+	{
+		if ( frame.path == true )
+			frame.color += frame.scale * color;
 
-		// air attenuation
-		auto& air = scene.air();
-		float traversed_dist = length( contact.point - ray.pos );
-		color *= glm::pow( air.attenuation, vec3( traversed_dist ) );
+		// next is past the ray, 1 for the refraction
+		else if ( frame.next == 1 && frame.transmission > 0.0f )
+			frame.color += frame.transmission * color;
+		else
+			frame.reflection_color += frame.reflection * color;
+	}
+
+	/**
+	* @brief get the color of a contact once all its rays are done
+	* @param frame				state of the contact
+	* @return color (not clamped)
+	*/
+	vec3 end_shading( const ShadeFrame& frame )
+	{
+		if ( frame.path == true )
+			return frame.color * frame.attenuation;
+
+		vec3 color = frame.color;
+
+		// normalize reflection color and add it to the result
+		if ( frame.reflection > 0.0f )
+		{
+			vec3 reflection_color = frame.reflection_color / static_cast<float>( frame.samples );
+			color += reflection_color;
+		}
+
+		color *= frame.attenuation;
 
 		return color;
 	}
 
 	/**
-	* @brief raycast all the objects in the scene
-	* @param scene	scene to raycast
-	* @param ray
-	* @return contact information of the raycast
+	* @brief compute the ray refracted at a contact
+	* @param ray				incoming ray
+	* @param N					normal facing the incoming ray
+	* @param contact_point		contact position moved inside the surface
+	* @param e_permittivity		electric permittivity of the medium the ray travels through
+	* @param m_permeability		magnetic permeability of the medium the ray travels through
+	* @param next_e_permittivity	electric permittivity of the medium the ray enters
+	* @param next_m_permeability	magnetic permeability of the medium the ray enters
+	* @return ray
 	*/
-	Intersection::Contact raycast_scene( const Scene& scene, const Shapes::Ray& ray )
+	Shapes::Ray refraction_ray( const Shapes::Ray& ray, const vec3& N, const vec3& contact_point, const float e_permittivity, const float m_permeability, const float next_e_permittivity, const float next_m_permeability )
 	{
-		Intersection::Contact result;
-		result.time = -1.0f;
+		// coefficients of refraction
+		float n_i = sqrt( e_permittivity * m_permeability );
+		float n_t = sqrt( next_e_permittivity * next_m_permeability );
+		float ior = n_i / n_t;
 
-		// get the shapes of the scene
-		const std::vector<Shapes::Shape*>& shapes = scene.shapes();
+		vec3 refr_dir = glm::refract( normalize( ray.dir ), N, ior );
 
-		// raycast shapes
-		for ( unsigned i = 0; i < shapes.size(); i++ )
-		{
-			// compute the intersection time of the ray with the shape
-			const Intersection::Contact contact = shapes[i]->intersect( ray );
+		return Shapes::Ray( contact_point, normalize( refr_dir ) );
+	}
 
-			// if an intersection happens take the closest value
-			if ( ( contact.time != -1.0f && contact.time < result.time ) || result.time == -1.0f )
-				result = contact;
-		}
+	/**
+	* @brief compute a ray reflected at a contact
+	* @param ray				incoming ray
+	* @param N					normal facing the incoming ray
+	* @param contact_point		contact position moved outside the surface
+	* @param roughness			radius of the random deviation of the reflection
+	* @param mirror				flag for the exact mirror direction instead of a random one
+	* @param sampler			values of the camera sample
+	* @param dimension			sampler dimension of the rough reflections of the contact (one)
+	* @param sample				rough reflection among the ones of the contact
+	* @param count				rough reflections of the contact
+	* @return ray
+	*/
+	Shapes::Ray reflection_ray( const Shapes::Ray& ray, const vec3& N, const vec3& contact_point, const float roughness, const bool mirror, Sampler& sampler, const unsigned dimension, const unsigned sample, const unsigned count )
+	{
+		const vec3 reflection_dir = normalize( glm::reflect( ray.dir, N ) );
+		if ( mirror )
+			return Shapes::Ray( contact_point, reflection_dir );
 
-		return result;
+		// random direction around the mirror one
+		return Shapes::Ray( contact_point, Sampling::uniform_cone( sampler.get_2d( dimension, sample, count ), reflection_dir, reflection_cone( roughness ) ) );
+	}
+
+	/**
+	* @brief cone of the rough reflections, the directions to the sphere of radius roughness at the end
+	* of the unit mirror direction (a roughness of 1 or more covers the half space around it)
+	* @param roughness
+	* @return cosine of the half angle of the cone
+	*/
+	float reflection_cone( const float roughness )
+	{
+		return std::sqrt( glm::max( 1.0f - roughness * roughness, 0.0f ) );
 	}
 
 	/**
 	* @brief compute the color of the pixel based on the light
 	* @param scene
 	* @param ray
-	* @param samples	shadow samples
-	* @param contact	contact information
+	* @param sampler		values of the camera sample
+	* @param samples		shadow samples
+	* @param min_samples	shadow samples traced first, the rest only if they disagree (0 for all, at least 2)
+	* @param contact		contact information
 	*/
-	vec3 raycast_lights( const Scene& scene, const Shapes::Ray& ray, const int samples, const vec3 contact_point, const vec3 contact_normal, const Material& material )
+	vec3 raycast_lights( const CompiledScene& scene, const Shapes::Ray& ray, Sampler& sampler, const int samples, const int min_samples, const vec3 contact_point, const vec3 contact_normal, const Material& material )
 	{
 		auto& lights = scene.lights();
 		auto& ambient_light = scene.ambient();
@@ -419,38 +1465,40 @@ namespace Raytracer
 
 		ambient = ambient_light.color * material.diffuse_color;
 
+		// samples that decide if a point is in the penumbra, at least the center and a random one (a
+		// single probe always agrees with itself and every soft shadow would be hard)
+		const int min_probes = std::max( min_samples, 2 );
+		const int probes = min_samples > 0 && min_probes < samples ? min_probes : samples;
+
 		for ( auto& light : lights )
 		{
 			// check for shadows
 			int oclusions = 0;
+			int traced = probes;
 
 			// distance to the light
-			float light_dist = dot( light.pos - contact_point, light.pos - contact_point );
+			float light_dist = length( light.pos - contact_point );
 
-			for ( int i = 0; i < samples; i++ )
-			{
-				// randomized point inside the light sphere
-				vec3 pos;
-				if ( i == 0 )
-					pos = light.pos;
-				else
-					pos = get_random_sample( light.pos, light.radius );
+			// the random points of a light are drawn together
+			const unsigned dimension = sampler.next_dimension( 2u );
 
-				// create a ray towards the light
-				Shapes::Ray light_ray( contact_point, normalize( pos - contact_point ) );
+			// first sample towards the center of the light
+			if ( probes > 0 && scene.occluded( Shapes::Ray( contact_point, normalize( light.pos - contact_point ) ), light_dist ) )
+				oclusions++;
 
-				// check for ocluder
-				auto ocluder = raycast_scene( scene, light_ray );
+			oclusions += count_occlusions( scene, light, contact_point, light_dist, sampler, dimension, 0, probes - 1, samples - 1 );
 
-				float ocluder_dist = dot( ocluder.point - contact_point, ocluder.point - contact_point );
-				if ( ocluder.time != -1.0f && ocluder_dist < light_dist )
-					oclusions++;
+			// the probes disagree -> penumbra, the rest of the samples are traced
+			if ( oclusions > 0 && oclusions < probes )
+			{
+				oclusions += count_occlusions( scene, light, contact_point, light_dist, sampler, dimension, probes - 1, samples - 1, samples - 1 );
+				traced = samples;
 			}
 
 			// shadow factor
 			float shadow = 1.0f;
-			if ( samples != 0.0f )
-				shadow = 1.0f - ( oclusions ) / static_cast< float >( samples );
+			if ( traced != 0 )
+				shadow = 1.0f - ( oclusions ) / static_cast< float >( traced );
 		
 
 
@@ -463,7 +1511,7 @@ namespace Raytracer
 			// accumulate specular
 			vec3 r = glm::reflect( ray.dir, contact_normal );
 
-			specular += material.specular_reflection * glm::max( pow<float>( dot( r, l ), material.specular_exponent ), 0.0f ) * material.diffuse_color * shadow;
+			specular += material.specular_reflection * glm::max( std::pow( dot( r, l ), material.specular_exponent ), 0.0f ) * material.diffuse_color * shadow;
 		}
 
 		// compute final color and clamp
@@ -473,29 +1521,72 @@ namespace Raytracer
 	}
 
 	/**
-	* @brief compute a random point in an sphere
-	* @param pos		position of the sphere
-	* @param radius		radius of the sphere
-	* @return point
+	* @brief count the occluded points of a light
+	* @param scene
+	* @param light
+	* @param contact_point
+	* @param light_dist		distance from the contact to the center of the light
+	* @param sampler		values of the camera sample
+	* @param dimension		sampler dimensions of the points of the light (two)
+	* @param begin			first point
+	* @param end			point after the last one
+	* @param count			points of the light, drawn together
+	* @return rays towards the points that hit something before the light
 	*/
-	vec3 get_random_sample( const vec3& pos, const float radius )
+	int count_occlusions( const CompiledScene& scene, const Lights::Point& light, const vec3& contact_point, const float light_dist, Sampler& sampler, const unsigned dimension, const int begin, const int end, const int count )
 	{
-		vec3 point;
+		int oclusions = 0;
+
+		// randomized points inside the light sphere, same values as get_random_sample
+		for ( int first = begin; first < end; first += shadow_batch )
+		{
+			const int batch = std::min( shadow_batch, end - first );
+
+			float u[shadow_batch], v[shadow_batch], w[shadow_batch];
+			for ( int k = 0; k < batch; k++ )
+			{
+				const vec2 direction = sampler.get_2d( dimension, first + k, count );
+				u[k] = direction.x;
+				v[k] = direction.y;
+				w[k] = sampler.get_1d( dimension + 1u, first + k, count );
+			}
+
+			float x[shadow_batch], y[shadow_batch], z[shadow_batch];
+			Sampling::uniform_ball( u, v, w, x, y, z, static_cast<unsigned>( batch ) );
+
+			for ( int k = 0; k < batch; k++ )
+			{
+				const vec3 pos = light.pos + vec3( x[k], y[k], z[k] ) * light.radius;
 
-		// get random coordinates in unit box
-		point.x = rand() / static_cast<float>( RAND_MAX ) - 0.5f;
-		point.y = rand() / static_cast<float>( RAND_MAX ) - 0.5f;
-		point.z = rand() / static_cast<float>( RAND_MAX ) - 0.5f;
+				// create a ray towards the light
+				Shapes::Ray light_ray( contact_point, normalize( pos - contact_point ) );
 
-		// normalize to get in unit sphere
-		point = normalize( point );
+				// check for ocluder between the point and the light
+				if ( scene.occluded( light_ray, light_dist ) )
+					oclusions++;
+			}
+		}
 
-		float u = rand() / static_cast<float>( RAND_MAX );
-		float c = std::cbrt( u );
+		return oclusions;
+	}
 
-		point *= u;
+	/**
+	* @brief compute a random point in an sphere
+	* @param pos		position of the sphere
+	* @param radius		radius of the sphere
+	* @param sampler	values of the camera sample
+	* @param dimension	sampler dimensions of the points drawn together (two)
+	* @param sample		point among the ones drawn together
+	* @param count		points drawn together
+	* @return point
+	*/
+	vec3 get_random_sample( const vec3& pos, const float radius, Sampler& sampler, const unsigned dimension, const unsigned sample, const unsigned count )
+	{
+		// direction from the first dimension, distance from the center from the second
+		const vec2 direction = sampler.get_2d( dimension, sample, count );
+		const float distance = sampler.get_1d( dimension + 1u, sample, count );
 
-		return pos + point * radius;
+		return pos + Sampling::uniform_ball( vec3( direction.x, direction.y, distance ) ) * radius;
 	}
 
 	/**
@@ -541,15 +1632,16 @@ namespace Raytracer
 	* @param camera
 	* @param pixel_pos		position of the current pixel in world coordinates
 	* @param focal_point	distance from the lens to the focal plane
+	* @param sampler		values of the camera sample
 	* @return random ray from the camera lens through the focus point
 	*/
-	Shapes::Ray compute_ray_dir_dof( const Camera& camera, const vec3& pixel_pos, const float focal_point )
+	Shapes::Ray compute_ray_dir_dof( const Camera& camera, const vec3& pixel_pos, const float focal_point, Sampler& sampler )
 	{
 		// compute ray from lense center
 		vec3 center_dir = normalize( pixel_pos - camera.pos );
 
 		// random offset in the lense
-		vec2 r_offset = camera.get_rand_lense_point();
+		vec2 r_offset = camera.get_rand_lense_point( sampler );
 
 		// point in focus
 		vec3 focus_plane_pos = camera.pos + focal_point * center_dir;
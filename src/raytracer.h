@@ -10,10 +10,15 @@ Creation date: 01/13/2020
 
 #pragma once
 
-#include "scene.h"
+#include "compiled_scene.h"
+#include "preview.h"
 
 #include "intersection.h"
 #include "math_utils.h"
+#include "random.h"
+#include "ray.h"
+#include "sampler.h"
+#include <functional>
 #include <vector>
 
 struct Configuration
@@ -22,16 +27,41 @@ struct Configuration
 	int		width, height;			// screen resolution
 	int		antialiasing_samples;	// total samples for antialiasing
 	bool	adaptive_antialiasing;	// flag for adaptive sampling
+	float	adaptive_threshold;		// standard error of the luminance of a pixel that makes adaptive sampling refine it
 	int		shadow_samples;			// total samples for shadows
+	int		shadow_min_samples;		// shadow samples of a light traced first, the rest only when they disagree (0 for all, at least 2)
 	bool	dof;					// flag for dof
 	int		dof_samples;			// total samples for depth of field
 	int		reflection_samples;		// total samples for reflection roughness
-	bool	window;					// flag for window preview
+	bool	path_tracing;			// flag for following a single random ray after the first bounce
+	bool	wavefront;				// flag for the wavefront engine, queues of rays traced stage by stage
+	bool	sort_rays;				// flag for tracing the secondary and shadow rays of the wavefront engine by direction and origin
+	bool	window;					// flag for window preview (builds with CS500_PREVIEW)
+	int		tile_size;				// side in pixels of the tiles handed to the threads
+	unsigned seed;					// seed of the random numbers, same seed -> same image
+	bool	packets;				// flag for tracing the camera rays in SIMD packets
+	bool	scene_cache;			// flag for loading / saving the compiled scene next to the scene file
+	bool	progressive;			// flag for rendering in passes of one sample per pixel
+	float	time_limit;				// seconds of rendering, the noisiest pixels get samples until then (0 for no limit)
+	Samplers::Type sampler;			// source of the values of the camera, lens, shadow and reflection samples
 
 	float epsilon;				// epsilon value
 };
 
 namespace Raytracer
 {
-	bool trace_scene( std::vector<unsigned char>& color_buffer, const Scene& scene, const Configuration& config );
+	// called with the image after every pass of a progressive render, and when the time limit is reached
+	using PassCallback = std::function<void( const std::vector<unsigned char>& color_buffer )>;
+
+	bool trace_scene( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, Preview* preview = nullptr, const PassCallback& on_pass = nullptr );
+
+	// shared by the render engines
+	void					write_pixel				( std::vector<unsigned char>& color_buffer, const Configuration& config, const int i, const int j, vec3 color );
+	int						pixel_samples			( const Configuration& config );
+	Shapes::Ray				compute_camera_ray		( const Camera& camera, const Configuration& config, const int i, const int j, const int sample, Sampler& sampler );
+	Shapes::Ray				refraction_ray			( const Shapes::Ray& ray, const vec3& N, const vec3& contact_point, const float e_permittivity, const float m_permeability, const float next_e_permittivity, const float next_m_permeability );
+	Shapes::Ray				reflection_ray			( const Shapes::Ray& ray, const vec3& N, const vec3& contact_point, const float roughness, const bool mirror, Sampler& sampler, const unsigned dimension, const unsigned sample, const unsigned count );
+	float					reflection_cone			( const float roughness );
+	vec3					get_random_sample		( const vec3& pos, const float radius, Sampler& sampler, const unsigned dimension, const unsigned sample, const unsigned count );
+	float					compute_reflection_coeff( const float eps_i, const float nu_i, const float eps_t, const float nu_t, const float incident_angle );
 }
\ No newline at end of file
@@ -0,0 +1,480 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: sampler.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	// largest float below 1
+	const float one_minus_epsilon = 0.99999994f;
+
+	// side of the blue noise tile, repeated over the image
+	const unsigned blue_noise_size = 64u;
+
+	/**
+	* @brief mix the bits of a value (lowbias32, Wellons)
+	* @param value
+	* @return hashed value
+	*/
+	uint32_t hash( uint32_t value )
+	{
+		value ^= value >> 16u;
+		value *= 0x7feb352du;
+		value ^= value >> 15u;
+		value *= 0x846ca68bu;
+		value ^= value >> 16u;
+		return value;
+	}
+
+	/**
+	* @brief hash two values together
+	* @param a
+	* @param b
+	* @return hashed value
+	*/
+	uint32_t hash( const uint32_t a, const uint32_t b )
+	{
+		return hash( a ^ ( hash( b ) + 0x9e3779b9u + ( a << 6u ) + ( a >> 2u ) ) );
+	}
+
+	/**
+	* @brief seed of a dimension of a pixel
+	* @param pixel
+	* @param seed			seed of the image
+	* @param dimension
+	* @return seed
+	*/
+	uint32_t pixel_seed( const glm::uvec2& pixel, const uint32_t seed, const uint32_t dimension )
+	{
+		// spatial hash of the pixel (Teschner 2003) mixed with the seed, then with the dimension
+		return hash( hash( ( pixel.x * 0x8da6b343u ) ^ ( pixel.y * 0xd8163841u ) ^ seed ) + dimension * 0x9e3779b9u );
+	}
+
+	/**
+	* @brief convert 32 random bits to a float
+	* @param bits
+	* @return value in [0, 1)
+	*/
+	float to_float( const uint32_t bits )
+	{
+		// 24 bits fit exactly in the mantissa
+		return static_cast<float>( bits >> 8u ) * ( 1.0f / 16777216.0f );
+	}
+
+	/**
+	* @brief reverse the order of the bits of a value
+	* @param value
+	* @return bit 31 goes to 0, 30 to 1...
+	*/
+	uint32_t reverse_bits( uint32_t value )
+	{
+		value = ( ( value >> 1u ) & 0x55555555u ) | ( ( value & 0x55555555u ) << 1u );
+		value = ( ( value >> 2u ) & 0x33333333u ) | ( ( value & 0x33333333u ) << 2u );
+		value = ( ( value >> 4u ) & 0x0F0F0F0Fu ) | ( ( value & 0x0F0F0F0Fu ) << 4u );
+		value = ( ( value >> 8u ) & 0x00FF00FFu ) | ( ( value & 0x00FF00FFu ) << 8u );
+		return ( value >> 16u ) | ( value << 16u );
+	}
+
+	/**
+	* @brief owen scrambling of the reversed bits of a value (Laine-Karras hash as improved by Burley 2020)
+	*
+	* Every bit is flipped depending on the seed and the bits below it, that are the bits above it
+	* once reversed back, so values in the same dyadic interval stay together and the stratification
+	* of a sequence is kept.
+	* @param reversed	value with its bits reversed
+	* @param seed
+	* @return scrambled value, still reversed
+	*/
+	uint32_t laine_karras( uint32_t reversed, const uint32_t seed )
+	{
+		reversed += seed;
+		reversed ^= reversed * 0x6c50b47cu;
+		reversed ^= reversed * 0xb82f1e52u;
+		reversed ^= reversed * 0xc7afe638u;
+		reversed ^= reversed * 0x8d22f6e6u;
+		return reversed;
+	}
+
+	/**
+	* @brief owen scrambling of the bits of a value
+	* @param value
+	* @param seed
+	* @return scrambled value
+	*/
+	uint32_t owen_scramble( const uint32_t value, const uint32_t seed )
+	{
+		return reverse_bits( laine_karras( reverse_bits( value ), seed ) );
+	}
+
+	/**
+	* @brief second dimension of the sobol sequence, with its bits reversed
+	*
+	* The value is the xor of a direction number for every set bit of the index, so it is the xor of
+	* the values of each byte of the index, read from tables built the first time. The first dimension
+	* is the index reversed (van der Corput), so both come reversed and ready to be scrambled.
+	* @param index
+	* @return 32 bit fraction, reversed
+	*/
+	uint32_t sobol_1_reversed( const uint32_t index )
+	{
+		struct Tables
+		{
+			uint32_t values[4][256];
+
+			Tables()
+			{
+				uint32_t directions[32];
+				directions[0] = 1u << 31u;
+				for ( unsigned bit = 1u; bit < 32u; bit++ )
+					directions[bit] = directions[bit - 1u] ^ ( directions[bit - 1u] >> 1u );
+
+				for ( unsigned byte = 0u; byte < 4u; byte++ )
+				{
+					for ( uint32_t value = 0u; value < 256u; value++ )
+					{
+						values[byte][value] = 0u;
+						for ( unsigned bit = 0u; bit < 8u; bit++ )
+						{
+							if ( value & ( 1u << bit ) )
+								values[byte][value] ^= reverse_bits( directions[byte * 8u + bit] );
+						}
+					}
+				}
+			}
+		};
+		static const Tables tables;
+
+		return tables.values[0][index & 0xFFu] ^ tables.values[1][( index >> 8u ) & 0xFFu] ^ tables.values[2][( index >> 16u ) & 0xFFu] ^ tables.values[3][index >> 24u];
+	}
+
+	/**
+	* @brief random permutation of [0, count) without tables (Kensler 2013, correlated multi-jittered sampling)
+	* @param index		value to permute
+	* @param count		size of the permutation
+	* @param seed		selects the permutation
+	* @return permuted value
+	*/
+	uint32_t permute( uint32_t index, const uint32_t count, const uint32_t seed )
+	{
+		uint32_t mask = count - 1u;
+		mask |= mask >> 1u;
+		mask |= mask >> 2u;
+		mask |= mask >> 4u;
+		mask |= mask >> 8u;
+		mask |= mask >> 16u;
+
+		// cycle walking, the values past count are permuted again
+		do
+		{
+			index ^= seed;				index *= 0xe170893du;
+			index ^= seed >> 16u;		index ^= ( index & mask ) >> 4u;
+			index ^= seed >> 8u;		index *= 0x0929eb3fu;
+			index ^= seed >> 23u;		index ^= ( index & mask ) >> 1u;
+			index *= 1u | seed >> 27u;	index *= 0x6935fa69u;
+			index ^= ( index & mask ) >> 11u;	index *= 0x74dcb303u;
+			index ^= ( index & mask ) >> 2u;	index *= 0x9e501cc3u;
+			index ^= ( index & mask ) >> 2u;	index *= 0xc860a3dfu;
+			index &= mask;
+			index ^= index >> 5u;
+		} while ( index >= count );
+
+		return ( index + seed ) % count;
+	}
+
+	/**
+	* @brief rank of every pixel of a tileable blue noise texture
+	*
+	* Points are added one by one in the emptiest place left, measured with a gaussian energy that
+	* wraps around the tile (the void filling step of void and cluster, Ulichney 1993). The order of
+	* insertion makes neighbouring pixels get values far apart.
+	* @return value of every pixel in (0, 1), row by row
+	*/
+	std::vector<float> build_blue_noise()
+	{
+		const int size = static_cast<int>( blue_noise_size );
+		const int pixel_count = size * size;
+		const int radius = 6;
+		const float sigma = 1.9f;
+
+		std::vector<float> kernel( ( 2 * radius + 1 ) * ( 2 * radius + 1 ) );
+		for ( int y = -radius; y <= radius; y++ )
+		{
+			for ( int x = -radius; x <= radius; x++ )
+				kernel[( y + radius ) * ( 2 * radius + 1 ) + x + radius] = std::exp( -static_cast<float>( x * x + y * y ) / ( 2.0f * sigma * sigma ) );
+		}
+
+		std::vector<float> energy( pixel_count, 0.0f );
+		std::vector<float> values( pixel_count, 0.0f );
+		std::vector<char> taken( pixel_count, 0 );
+
+		for ( int rank = 0; rank < pixel_count; rank++ )
+		{
+			// emptiest pixel left
+			int best = -1;
+			for ( int p = 0; p < pixel_count; p++ )
+			{
+				if ( taken[p] == 0 && ( best < 0 || energy[p] < energy[best] ) )
+					best = p;
+			}
+
+			taken[best] = 1;
+			values[best] = ( static_cast<float>( rank ) + 0.5f ) / static_cast<float>( pixel_count );
+
+			const int best_x = best % size;
+			const int best_y = best / size;
+			for ( int y = -radius; y <= radius; y++ )
+			{
+				for ( int x = -radius; x <= radius; x++ )
+				{
+					const int p = ( ( best_y + y + size ) % size ) * size + ( best_x + x + size ) % size;
+					energy[p] += kernel[( y + radius ) * ( 2 * radius + 1 ) + x + radius];
+				}
+			}
+		}
+
+		return values;
+	}
+
+	/**
+	* @brief value of the blue noise tile at a pixel
+	* @param x
+	* @param y
+	* @return value in (0, 1)
+	*/
+	float blue_noise( const uint32_t x, const uint32_t y )
+	{
+		// built the first time, the initialization of a local static is thread safe
+		static const std::vector<float> tile = build_blue_noise();
+		return tile[( y % blue_noise_size ) * blue_noise_size + x % blue_noise_size];
+	}
+
+	/**
+	* @brief correlated multi-jittered samples (Kensler 2013)
+	*
+	* The samples of the pixel fall in the cells of a grid and their projections on each axis fall in
+	* different strata too. The order of the samples is shuffled for every pixel and dimension.
+	*/
+	class StratifiedGenerator : public Samplers::Generator
+	{
+	public:
+		/**
+		* @brief get a value of a dimension, one per stratum of the unit interval
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample (past count for extra samples, those are random)
+		* @param count			samples of the pixel
+		* @param dimension
+		* @return value in [0, 1)
+		*/
+		float get_1d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t count, const uint32_t dimension ) const override
+		{
+			const uint32_t p = pixel_seed( pixel, seed, dimension );
+			if ( index >= count )
+				return to_float( hash( index ^ p ) );
+
+			const float jitter = to_float( hash( index ^ ( p * 0xa399d265u ) ) );
+			return std::min( ( static_cast<float>( permute( index, count, p ) ) + jitter ) / static_cast<float>( count ), one_minus_epsilon );
+		}
+
+		/**
+		* @brief get a pair of values of a dimension, one per cell of a grid
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample (past count for extra samples, those are random)
+		* @param count			samples of the pixel
+		* @param dimension
+		* @return values in [0, 1)
+		*/
+		vec2 get_2d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t count, const uint32_t dimension ) const override
+		{
+			const uint32_t p = pixel_seed( pixel, seed, dimension );
+			if ( index >= count )
+				return vec2( to_float( hash( index ^ p ) ), to_float( hash( index ^ ( p * 0x711ad6a5u ) ) ) );
+
+			// columns x rows covering the samples, the last cells are empty if count is not a product
+			const uint32_t columns = std::max( static_cast<uint32_t>( std::sqrt( static_cast<float>( count ) ) ), 1u );
+			const uint32_t rows = ( count + columns - 1u ) / columns;
+
+			const uint32_t s = permute( index, count, p * 0x51633e2du );
+			const uint32_t sx = permute( s % columns, columns, p * 0x68bc21ebu );
+			const uint32_t sy = permute( s / columns, rows, p * 0x02e5be93u );
+			const float jx = to_float( hash( s ^ ( p * 0x967a889bu ) ) );
+			const float jy = to_float( hash( s ^ ( p * 0x368cc8b7u ) ) );
+
+			const float x = ( static_cast<float>( s % columns ) + ( static_cast<float>( sy ) + jx ) / static_cast<float>( rows ) ) / static_cast<float>( columns );
+			const float y = ( static_cast<float>( s / columns ) + ( static_cast<float>( sx ) + jy ) / static_cast<float>( columns ) ) / static_cast<float>( rows );
+			return glm::min( vec2( x, y ), vec2( one_minus_epsilon ) );
+		}
+	};
+
+	/**
+	* @brief owen scrambled sobol points (Burley 2020, practical hash-based owen scrambling)
+	*
+	* Every dimension is a pair of the first two sobol dimensions, with its own scrambling and its
+	* own shuffle of the sample order so the dimensions are not correlated (padding). Any power of
+	* two samples of a pixel are well distributed, and more samples keep improving it.
+	*/
+	class SobolGenerator : public Samplers::Generator
+	{
+	public:
+		/**
+		* @brief get a value of a dimension
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample
+		* @param count			samples of the pixel (not needed, the sequence is progressive)
+		* @param dimension
+		* @return value in [0, 1)
+		*/
+		float get_1d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t, const uint32_t dimension ) const override
+		{
+			const uint32_t p = pixel_seed( pixel, seed, dimension );
+			return to_float( reverse_bits( laine_karras( owen_scramble( index, p ), hash( p + 1u ) ) ) );
+		}
+
+		/**
+		* @brief get a pair of values of a dimension
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample
+		* @param count			samples of the pixel (not needed, the sequence is progressive)
+		* @param dimension
+		* @return values in [0, 1)
+		*/
+		vec2 get_2d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t, const uint32_t dimension ) const override
+		{
+			return sobol_2d( pixel_seed( pixel, seed, dimension ), index );
+		}
+
+		/**
+		* @brief get a scrambled sobol point
+		* @param p				seed of the scrambling and the shuffle
+		* @param index			sample
+		* @return values in [0, 1)
+		*/
+		static vec2 sobol_2d( const uint32_t p, const uint32_t index )
+		{
+			const uint32_t shuffled = owen_scramble( index, p );
+			const uint32_t x = reverse_bits( laine_karras( shuffled, hash( p + 1u ) ) );
+			const uint32_t y = reverse_bits( laine_karras( sobol_1_reversed( shuffled ), hash( p + 2u ) ) );
+			return vec2( to_float( x ), to_float( y ) );
+		}
+	};
+
+	/**
+	* @brief the same owen scrambled sobol points in every pixel, offset by a blue noise texture
+	*
+	* The points of each pixel are shifted (Cranley-Patterson rotation) by the value of the tile at the
+	* pixel, so the errors of neighbouring pixels are different and the noise of the image is blue
+	* noise instead of white noise (Georgiev and Fajardo 2016), less visible at the same sample count.
+	*/
+	class BlueNoiseGenerator : public Samplers::Generator
+	{
+	public:
+		/**
+		* @brief get a value of a dimension
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample
+		* @param count			samples of the pixel (not needed, the sequence is progressive)
+		* @param dimension
+		* @return value in [0, 1)
+		*/
+		float get_1d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t count, const uint32_t dimension ) const override
+		{
+			return get_2d( pixel, seed, index, count, dimension ).x;
+		}
+
+		/**
+		* @brief get a pair of values of a dimension
+		* @param pixel
+		* @param seed			seed of the image
+		* @param index			sample
+		* @param count			samples of the pixel (not needed, the sequence is progressive)
+		* @param dimension
+		* @return values in [0, 1)
+		*/
+		vec2 get_2d( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t, const uint32_t dimension ) const override
+		{
+			const uint32_t p = hash( seed, dimension );
+			const vec2 point = SobolGenerator::sobol_2d( p, index );
+
+			// each dimension and axis reads the tile from another place
+			const uint32_t offset_x = hash( p + 3u );
+			const uint32_t offset_y = hash( p + 4u );
+			const vec2 shift( blue_noise( pixel.x + offset_x, pixel.y + ( offset_x >> 16u ) ), blue_noise( pixel.x + offset_y, pixel.y + ( offset_y >> 16u ) ) );
+
+			return glm::min( glm::fract( point + shift ), vec2( one_minus_epsilon ) );
+		}
+	};
+}
+
+namespace Samplers
+{
+	/**
+	* @brief get the generator of a type of sampler
+	* @param type
+	* @return shared generator, nullptr for the random sequence
+	*/
+	const Generator* generator( const Type type )
+	{
+		static const StratifiedGenerator	stratified;
+		static const SobolGenerator			sobol;
+		static const BlueNoiseGenerator		blue_noise;
+
+		switch ( type )
+		{
+		case Type::stratified:	return &stratified;
+		case Type::sobol:		return &sobol;
+		case Type::blue_noise:	return &blue_noise;
+		default:				return nullptr;
+		}
+	}
+
+	/**
+	* @brief read the name of a sampler
+	* @param name		random, stratified, sobol or bluenoise
+	* @param type		(return)
+	* @return false if the name is unknown
+	*/
+	bool parse_type( const std::string& name, Type& type )
+	{
+		for ( const Type candidate : { Type::random, Type::stratified, Type::sobol, Type::blue_noise } )
+		{
+			if ( name == type_name( candidate ) )
+			{
+				type = candidate;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	* @brief get the name of a sampler
+	* @param type
+	* @return name as written in the config file
+	*/
+	const char* type_name( const Type type )
+	{
+		switch ( type )
+		{
+		case Type::stratified:	return "stratified";
+		case Type::sobol:		return "sobol";
+		case Type::blue_noise:	return "bluenoise";
+		default:				return "random";
+		}
+	}
+}
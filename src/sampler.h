@@ -0,0 +1,160 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: sampler.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+#include "random.h"
+#include <cstdint>
+#include <string>
+
+namespace Samplers
+{
+	enum class Type { random, stratified, sobol, blue_noise };
+
+	// dimensions of a sample drawn from the generator, the ones past it come from the random sequence
+	const unsigned max_dimensions = 32u;
+
+	/**
+	* @brief source of well distributed values for the samples of a pixel, shared by every thread
+	*
+	* A dimension is one use of random values in a camera sample (position in the pixel, point in the
+	* lens, point in a light...). The values of a dimension are spread over all the samples of the
+	* pixel, the index of a sample selects its value. Values are a pure function of the arguments.
+	*/
+	class Generator
+	{
+	public:
+		virtual ~Generator() = default;
+
+		virtual float	get_1d	( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t count, const uint32_t dimension ) const = 0;
+		virtual vec2	get_2d	( const glm::uvec2& pixel, const uint32_t seed, const uint32_t index, const uint32_t count, const uint32_t dimension ) const = 0;
+	};
+
+	const Generator*	generator	( const Type type );
+	bool				parse_type	( const std::string& name, Type& type );
+	const char*			type_name	( const Type type );
+}
+
+/**
+* @brief values used by one camera sample of a pixel and the rays it spawns
+*
+* Every use of random values takes the next dimension. Values that are drawn together (the shadow
+* samples of a light, the reflection samples of a contact) take one dimension and their own index
+* in it, so they are spread among themselves too. Without a generator, and past the last dimension,
+* the values come from the random sequence of the pixel in the order they are asked for.
+*/
+class Sampler
+{
+public:
+
+	Sampler() = default;
+	Sampler( const Samplers::Type type, const uint64_t seed, const int i, const int j, Random& rng );
+
+	void		start			( const unsigned index, const unsigned count );
+	unsigned	next_dimension	( const unsigned amount = 1u );
+	float		get_1d			( const unsigned dimension, const unsigned i = 0u, const unsigned count = 1u );
+	vec2		get_2d			( const unsigned dimension, const unsigned i = 0u, const unsigned count = 1u );
+	float		next_float		();
+
+	unsigned	dimension		() const { return m_dimension; }
+	void		set_dimension	( const unsigned dimension ) { m_dimension = dimension; }
+
+private:
+	const Samplers::Generator*	m_generator = nullptr;
+	Random*						m_rng = nullptr;
+	glm::uvec2					m_pixel = glm::uvec2( 0u );
+	uint32_t					m_seed = 0u;
+	unsigned					m_index = 0u;		// camera sample of the pixel
+	unsigned					m_count = 1u;		// camera samples of the pixel
+	unsigned					m_dimension = 0u;	// next dimension to use
+};
+
+/**
+* @brief sampler constructor
+* @param type		generator of the values
+* @param seed		seed of the image
+* @param i			row of the pixel
+* @param j			column of the pixel
+* @param rng		random sequence of the pixel, for the values without generator
+*/
+inline Sampler::Sampler( const Samplers::Type type, const uint64_t seed, const int i, const int j, Random& rng ) :
+	m_generator( Samplers::generator( type ) ), m_rng( &rng ), m_pixel( static_cast<unsigned>( j ), static_cast<unsigned>( i ) ),
+	m_seed( static_cast<uint32_t>( seed ^ ( seed >> 32u ) ) )
+{
+}
+
+/**
+* @brief start a camera sample, from the first dimension
+* @param index		camera sample of the pixel (can be past count for the extra samples)
+* @param count		camera samples of the pixel
+*/
+inline void Sampler::start( const unsigned index, const unsigned count )
+{
+	m_index = index;
+	m_count = count;
+	m_dimension = 0u;
+}
+
+/**
+* @brief take the next dimensions of the sample
+* @param amount
+* @return first dimension taken
+*/
+inline unsigned Sampler::next_dimension( const unsigned amount )
+{
+	const unsigned dimension = m_dimension;
+	m_dimension += amount;
+	return dimension;
+}
+
+/**
+* @brief get a value of a dimension
+* @param dimension	taken with next_dimension
+* @param i			value among the ones drawn together
+* @param count		values drawn together
+* @return value in [0, 1)
+*/
+inline float Sampler::get_1d( const unsigned dimension, const unsigned i, const unsigned count )
+{
+	if ( m_generator == nullptr || dimension >= Samplers::max_dimensions )
+		return m_rng->next_float();
+
+	return m_generator->get_1d( m_pixel, m_seed, m_index * count + i, m_count * count, dimension );
+}
+
+/**
+* @brief get a pair of values of a dimension
+* @param dimension	taken with next_dimension
+* @param i			value among the ones drawn together
+* @param count		values drawn together
+* @return values in [0, 1)
+*/
+inline vec2 Sampler::get_2d( const unsigned dimension, const unsigned i, const unsigned count )
+{
+	if ( m_generator == nullptr || dimension >= Samplers::max_dimensions )
+	{
+		// drawn in order, same sequence as two calls to next_float
+		const float x = m_rng->next_float();
+		const float y = m_rng->next_float();
+		return vec2( x, y );
+	}
+
+	return m_generator->get_2d( m_pixel, m_seed, m_index * count + i, m_count * count, dimension );
+}
+
+/**
+* @brief get a value from the random sequence, for the choices that do not need a good distribution
+* @return value in [0, 1)
+*/
+inline float Sampler::next_float()
+{
+	return m_rng->next_float();
+}
@@ -0,0 +1,155 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: sampling.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "sampling.h"
+
+#include <algorithm>
+
+namespace Sampling
+{
+	/**
+	* @brief uniform points on the unit sphere, structure of arrays
+	* @param u			heights
+	* @param v			angles
+	* @param x			(return)
+	* @param y			(return)
+	* @param z			(return)
+	* @param count
+	*/
+	void uniform_sphere( const float* u, const float* v, float* x, float* y, float* z, const unsigned count )
+	{
+		// same steps as the single point, on floats so the loop is vectorized
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const float height = 1.0f - 2.0f * u[i];
+			const float r = std::sqrt( std::max( 1.0f - height * height, 0.0f ) );
+
+			float sine, cosine;
+			sin_cos_turns( v[i], sine, cosine );
+			x[i] = r * cosine;
+			y[i] = r * sine;
+			z[i] = height;
+		}
+	}
+
+	/**
+	* @brief uniform points in the unit ball, structure of arrays
+	* @param u			heights of the directions
+	* @param v			angles of the directions
+	* @param w			radii
+	* @param x			(return)
+	* @param y			(return)
+	* @param z			(return)
+	* @param count
+	*/
+	void uniform_ball( const float* u, const float* v, const float* w, float* x, float* y, float* z, const unsigned count )
+	{
+		uniform_sphere( u, v, x, y, z, count );
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const float radius = cube_root( w[i] );
+			x[i] *= radius;
+			y[i] *= radius;
+			z[i] *= radius;
+		}
+	}
+
+	/**
+	* @brief uniform points in the unit disk, structure of arrays
+	* @param u
+	* @param v
+	* @param x			(return)
+	* @param y			(return)
+	* @param count
+	*/
+	void concentric_disk( const float* u, const float* v, float* x, float* y, const unsigned count )
+	{
+		// same steps as the single point, on floats so the loop is vectorized
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const float a = 2.0f * u[i] - 1.0f;
+			const float b = 2.0f * v[i] - 1.0f;
+
+			const bool horizontal = std::abs( a ) > std::abs( b );
+			const float radius = horizontal ? a : b;
+			const float safe_radius = radius != 0.0f ? radius : 1.0f;
+			const float turns = horizontal ? 0.125f * b / safe_radius : 0.25f - 0.125f * a / safe_radius;
+
+			float sine, cosine;
+			sin_cos_turns( turns, sine, cosine );
+			x[i] = radius * cosine;
+			y[i] = radius * sine;
+		}
+	}
+
+	/**
+	* @brief directions around a normal with a density proportional to the cosine, structure of arrays
+	* @param u
+	* @param v
+	* @param n			unit normal
+	* @param x			(return)
+	* @param y			(return)
+	* @param z			(return)
+	* @param count
+	*/
+	void cosine_hemisphere( const float* u, const float* v, const vec3& n, float* x, float* y, float* z, const unsigned count )
+	{
+		// the points of the disk are written to x and y, then lifted in place
+		concentric_disk( u, v, x, y, count );
+
+		// local copy, the outputs could alias the normal and the loop would not be vectorized
+		const vec3 normal = n;
+		vec3 tangent, bitangent;
+		basis( normal, tangent, bitangent );
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const float a = x[i];
+			const float b = y[i];
+			const float height = std::sqrt( std::max( 1.0f - a * a - b * b, 0.0f ) );
+			x[i] = tangent.x * a + bitangent.x * b + normal.x * height;
+			y[i] = tangent.y * a + bitangent.y * b + normal.y * height;
+			z[i] = tangent.z * a + bitangent.z * b + normal.z * height;
+		}
+	}
+
+	/**
+	* @brief uniform directions inside a cone, structure of arrays
+	* @param u			heights
+	* @param v			angles
+	* @param axis		unit direction of the cone
+	* @param cos_max	cosine of the half angle of the cone
+	* @param x			(return)
+	* @param y			(return)
+	* @param z			(return)
+	* @param count
+	*/
+	void uniform_cone( const float* u, const float* v, const vec3& axis, const float cos_max, float* x, float* y, float* z, const unsigned count )
+	{
+		// the frame is the same for every direction, the axis is copied so the outputs can not alias it
+		const vec3 direction = axis;
+		vec3 tangent, bitangent;
+		basis( direction, tangent, bitangent );
+
+		// same steps as the single direction, on floats so the loop is vectorized
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const float cos_theta = 1.0f - u[i] * ( 1.0f - cos_max );
+			const float sin_theta = std::sqrt( std::max( 1.0f - cos_theta * cos_theta, 0.0f ) );
+
+			float sine, cosine;
+			sin_cos_turns( v[i], sine, cosine );
+			const float a = sin_theta * cosine;
+			const float b = sin_theta * sine;
+			x[i] = tangent.x * a + bitangent.x * b + direction.x * cos_theta;
+			y[i] = tangent.y * a + bitangent.y * b + direction.y * cos_theta;
+			z[i] = tangent.z * a + bitangent.z * b + direction.z * cos_theta;
+		}
+	}
+}
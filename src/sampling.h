@@ -0,0 +1,187 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: sampling.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "math_utils.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+* Mappings of values in [0, 1) to points with a uniform (or cosine) density. The random values are
+* given by the caller, so the samplers keep their stratification through the mapping. Every mapping
+* keeps areas and has no loops or data dependent jumps: the choices are selects, sine and cosine are
+* polynomials and the cube root is a few newton steps, the only library calls are sqrt, abs and
+* copysign, that are single instructions. Every mapping has a batch version that works on arrays so
+* the compiler turns it into vector code.
+*/
+namespace Sampling
+{
+	/**
+	* @brief sine and cosine of a fraction of a turn
+	*
+	* The turn is split in quarters, the polynomials of the angle to the nearest quarter (at most an
+	* eighth of a turn) are exact to float precision.
+	* @param turns		angle in turns (1 is 2 pi), from -1 to 1
+	* @param sine		(return)
+	* @param cosine		(return)
+	*/
+	inline void sin_cos_turns( const float turns, float& sine, float& cosine )
+	{
+		// rounded by truncation of a positive value, floor is not vectorized
+		const float quarters = turns * 4.0f;
+		const int quarter = static_cast<int>( quarters + 4.5f ) - 4;
+
+		const float angle = ( quarters - static_cast<float>( quarter ) ) * glm::half_pi<float>();
+		const float angle2 = angle * angle;
+		const float s = angle * ( 1.0f + angle2 * ( -1.0f / 6.0f + angle2 * ( 1.0f / 120.0f + angle2 * ( -1.0f / 5040.0f ) ) ) );
+		const float c = 1.0f + angle2 * ( -0.5f + angle2 * ( 1.0f / 24.0f + angle2 * ( -1.0f / 720.0f + angle2 * ( 1.0f / 40320.0f ) ) ) );
+
+		// rotate by the quarters: an odd one swaps the axes, the second one flips them
+		const bool odd = ( quarter & 1 ) != 0;
+		const float flip = ( quarter & 2 ) != 0 ? -1.0f : 1.0f;
+		sine = flip * ( odd ? c : s );
+		cosine = flip * ( odd ? -s : c );
+	}
+
+	/**
+	* @brief cube root of a value in [0, 1]
+	*
+	* First guess from the exponent bits divided by three, then newton iterations.
+	* @param value
+	* @return cube root, error below 1e-6
+	*/
+	inline float cube_root( const float value )
+	{
+		// tiny instead of zero so the iterations never divide by zero
+		const float clamped = glm::max( value, 1e-30f );
+
+		uint32_t bits;
+		std::memcpy( &bits, &clamped, sizeof( bits ) );
+		bits = bits / 3u + 0x2a5137a0u;
+
+		float root;
+		std::memcpy( &root, &bits, sizeof( root ) );
+		root = ( 2.0f * root + clamped / ( root * root ) ) * ( 1.0f / 3.0f );
+		root = ( 2.0f * root + clamped / ( root * root ) ) * ( 1.0f / 3.0f );
+		root = ( 2.0f * root + clamped / ( root * root ) ) * ( 1.0f / 3.0f );
+		return root;
+	}
+
+	/**
+	* @brief build two axes perpendicular to a direction (Duff et al. 2017, without branches)
+	* @param n			unit direction
+	* @param tangent	(return)
+	* @param bitangent	(return)
+	*/
+	inline void basis( const vec3& n, vec3& tangent, vec3& bitangent )
+	{
+		const float sign = std::copysign( 1.0f, n.z );
+		const float a = -1.0f / ( sign + n.z );
+		const float b = n.x * n.y * a;
+		tangent = vec3( 1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x );
+		bitangent = vec3( b, sign + n.y * n.y * a, -n.y );
+	}
+
+	/**
+	* @brief uniform point on the unit sphere (archimedes: the height is uniform)
+	* @param u			height and angle
+	* @return unit direction
+	*/
+	inline vec3 uniform_sphere( const vec2& u )
+	{
+		const float z = 1.0f - 2.0f * u.x;
+		const float r = std::sqrt( glm::max( 1.0f - z * z, 0.0f ) );
+
+		float sine, cosine;
+		sin_cos_turns( u.y, sine, cosine );
+		return vec3( r * cosine, r * sine, z );
+	}
+
+	/**
+	* @brief uniform point in the unit ball
+	* @param u			height and angle of the direction, radius
+	* @return point
+	*/
+	inline vec3 uniform_ball( const vec3& u )
+	{
+		// the volume inside a radius grows with its cube
+		return uniform_sphere( vec2( u.x, u.y ) ) * cube_root( u.z );
+	}
+
+	/**
+	* @brief uniform point in the unit disk (Shirley and Chiu 1997, concentric squares to circles)
+	*
+	* Neighbouring values stay neighbouring points, unlike the polar mapping that squeezes the
+	* strata near the center.
+	* @param u
+	* @return point
+	*/
+	inline vec2 concentric_disk( const vec2& u )
+	{
+		const float a = 2.0f * u.x - 1.0f;
+		const float b = 2.0f * u.y - 1.0f;
+
+		// the largest coordinate is the radius, the other one the angle inside its quadrant
+		const bool horizontal = std::abs( a ) > std::abs( b );
+		const float radius = horizontal ? a : b;
+		const float safe_radius = radius != 0.0f ? radius : 1.0f;
+		const float turns = horizontal ? 0.125f * b / safe_radius : 0.25f - 0.125f * a / safe_radius;
+
+		float sine, cosine;
+		sin_cos_turns( turns, sine, cosine );
+		return vec2( radius * cosine, radius * sine );
+	}
+
+	/**
+	* @brief direction around a normal with a density proportional to the cosine (malley's method)
+	* @param u
+	* @param n			unit normal
+	* @return unit direction
+	*/
+	inline vec3 cosine_hemisphere( const vec2& u, const vec3& n )
+	{
+		// the points of the disk lifted to the hemisphere
+		const vec2 disk = concentric_disk( u );
+		const float z = std::sqrt( glm::max( 1.0f - dot( disk, disk ), 0.0f ) );
+
+		vec3 tangent, bitangent;
+		basis( n, tangent, bitangent );
+		return tangent * disk.x + bitangent * disk.y + n * z;
+	}
+
+	/**
+	* @brief uniform direction inside a cone
+	* @param u			height and angle
+	* @param axis		unit direction of the cone
+	* @param cos_max	cosine of the half angle of the cone
+	* @return unit direction
+	*/
+	inline vec3 uniform_cone( const vec2& u, const vec3& axis, const float cos_max )
+	{
+		// the solid angle grows linearly with the cosine, as the area of a sphere with the height
+		const float cos_theta = 1.0f - u.x * ( 1.0f - cos_max );
+		const float sin_theta = std::sqrt( glm::max( 1.0f - cos_theta * cos_theta, 0.0f ) );
+
+		float sine, cosine;
+		sin_cos_turns( u.y, sine, cosine );
+
+		vec3 tangent, bitangent;
+		basis( axis, tangent, bitangent );
+		return tangent * ( sin_theta * cosine ) + bitangent * ( sin_theta * sine ) + axis * cos_theta;
+	}
+
+	void uniform_sphere		( const float* u, const float* v, float* x, float* y, float* z, const unsigned count );
+	void uniform_ball		( const float* u, const float* v, const float* w, float* x, float* y, float* z, const unsigned count );
+	void concentric_disk	( const float* u, const float* v, float* x, float* y, const unsigned count );
+	void cosine_hemisphere	( const float* u, const float* v, const vec3& n, float* x, float* y, float* z, const unsigned count );
+	void uniform_cone		( const float* u, const float* v, const vec3& axis, const float cos_max, float* x, float* y, float* z, const unsigned count );
+}
@@ -11,7 +11,7 @@ Creation date: 01/08/2020
 #include "scene.h"
 
 #include <fstream>
-#include <iostream>
+#include <memory>
 
 
 /**
@@ -26,43 +26,33 @@ Scene::Scene( const char* filename )
 /**
 * @load the scene from a file
 * @param filename	path of the file
+* @throw ParseError if the file can not be read or has invalid data
 */
 void Scene::load_scene( const char * filename )
 {
 	// clear data if any
 	clear();
 
-	std::ifstream file;
-	file.open( filename );
+	std::ifstream file( filename, std::ios::binary );
 
 	// sanity check
-	try
-	{
-		if ( !file )
-			throw "invalid file path";
-	}
-	catch ( const char* error )
-	{
-		std::cout << error << std::endl;
-		std::abort();
-	}
+	if ( !file )
+		throw ParseError( std::string( filename ) + ": invalid file path" );
 
-	// copy the file stream to the stream buffer
+	// copy the whole file once
 	std::string file_data;
 	file.seekg( 0, std::ios::end );
-	file_data.reserve( file.tellg() );
+	file_data.resize( static_cast<size_t>( file.tellg() ) );
 	file.seekg( 0, std::ios::beg );
-	file_data.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+	file.read( &file_data[0], file_data.size() );
 
 	// close the file
 	file.close();
 
-	// proccess data
-	while ( file_data.empty() == false )
-	{
-		// proccess the line
-		read_line( file_data );
-	}
+	// proccess data in a single pass
+	Parser parser( file_data, filename );
+	while ( parser.at_end() == false )
+		read_entry( parser );
 }
 
 /**
@@ -81,211 +71,180 @@ void Scene::clear()
 	for ( auto shape : m_shapes )
 		delete shape;
 	m_shapes.clear();
+	m_lights.clear();
+	m_use_bvh = true;
+	m_mesh_data.clear();
+	m_dependencies.clear();
+	m_obj_stats = Obj::Stats();
 }
 
-
 /**
-* @brief proccess a line of the scene to load
-* @param line	line to process
+* @brief proccess an entry of the scene (keyword and its values)
+* @param parser		scene file being read
 */
-void Scene::read_line( std::string& line )
+void Scene::read_entry( Parser& parser )
 {
-	// skip comments
-	if ( line.rfind( '#', 0u ) == 0u )
-	{
-		line = line.substr( line.find( '\n' ) + 1u );
-		return;
-	}
-		
-
+	const std::string_view keyword = parser.read_word();
 
 	// read sphere
-	if ( line.rfind( "SPHERE", 0u ) == 0u )
-	{
-		Shapes::Sphere* sphere = read_sphere( line );
-		m_shapes.push_back( sphere );
-		return;
-	}
+	if ( keyword == "SPHERE" )
+		m_shapes.push_back( read_sphere( parser ) );
 
 	// read box
-	if ( line.rfind( "BOX", 0u ) == 0u )
-	{
-		Shapes::Box* box = read_box( line );
-		m_shapes.push_back( box );
-		return;
-	}
+	else if ( keyword == "BOX" )
+		m_shapes.push_back( read_box( parser ) );
 
 	// read polygon
-	if ( line.rfind( "POLYGON", 0u ) == 0u )
-	{
-		Shapes::Polygon* polygon = read_polygon( line );
-		m_shapes.push_back( polygon );
-		return;
-	}
+	else if ( keyword == "POLYGON" )
+		m_shapes.push_back( read_polygon( parser ) );
 
 	// read ellipsoid
-	if ( line.rfind( "ELLIPSOID", 0u ) == 0u )
-	{
-		Shapes::Ellipsoid* ellipsoid = read_ellipsoid( line );
-		m_shapes.push_back( ellipsoid );
-		return;
-	}
+	else if ( keyword == "ELLIPSOID" )
+		m_shapes.push_back( read_ellipsoid( parser ) );
 
 	// read mesh
-	if ( line.rfind( "MESH", 0u ) == 0u )
-	{
-		Shapes::Mesh* mesh = read_mesh( line );
-		m_shapes.push_back( mesh );
-		return;
-	}
+	else if ( keyword == "MESH" )
+		m_shapes.push_back( read_mesh( parser ) );
 
 	// read light
-	if ( line.rfind( "LIGHT", 0u ) == 0u )
-	{
-		Lights::Point light = read_point_light( line );
-		m_lights.push_back( light );
-		return;
-	}
+	else if ( keyword == "LIGHT" )
+		m_lights.push_back( read_point_light( parser ) );
 
 	// read ambient
-	if ( line.rfind( "AMBIENT", 0u ) == 0u )
-	{
-		m_ambient = read_ambient( line );
-		return;
-	}
+	else if ( keyword == "AMBIENT" )
+		m_ambient = read_ambient( parser );
 
 	// read air
-	if ( line.rfind( "AIR", 0u ) == 0u )
-	{
-		m_air = read_air( line );
-		return;
-	}
+	else if ( keyword == "AIR" )
+		m_air = read_air( parser );
+
+	// read acceleration switch
+	else if ( keyword == "BVH" )
+		m_use_bvh = parser.read_int() != 0;
 
 	// read camera
-	if ( line.rfind( "CAMERA", 0u ) == 0u )
-	{
-		m_camera = read_camera( line );
-		return;
-	}
+	else if ( keyword == "CAMERA" )
+		m_camera = read_camera( parser );
 
-	// empty lines
 	else
-	{
-		line = line.substr( 1u );
-		return;
-	}
+		parser.error( "unknown keyword '" + std::string( keyword ) + "'", parser.position() - keyword.size() );
 }
 
 /**
 * @brief read sphere data
-* @param data
+* @param parser
 * @return Sphere
 */
-Shapes::Sphere* Scene::read_sphere( std::string& data )
+Shapes::Sphere* Scene::read_sphere( Parser& parser )
 {
-	Shapes::Sphere* sphere = new Shapes::Sphere;
+	auto sphere = std::make_unique<Shapes::Sphere>();
 
-	sphere->pos			= read_vector( data );		// position values
-	sphere->radius		= read_float( data );	// read radius
+	sphere->pos			= parser.read_vector();		// position values
+	sphere->radius		= parser.read_float();	// read radius
 
-	sphere->material		= read_material( data );	// read the material properties
+	sphere->material		= read_material( parser );	// read the material properties
 
-	return sphere;
+	return sphere.release();
 }
 
 /**
 * @brief read box data
-* @param data
+* @param parser
 * @return box
 */
-Shapes::Box* Scene::read_box( std::string& data )
+Shapes::Box* Scene::read_box( Parser& parser )
 {
-	Shapes::Box* box = new Shapes::Box;
-
-	box->pos			= read_vector( data );		// corner
-	box->length			= read_vector( data );		// length
-	box->width			= read_vector( data );		// width
-	box->height			= read_vector( data );		// height
+	auto box = std::make_unique<Shapes::Box>();
 
-	box->generate_planes();
+	box->pos			= parser.read_vector();		// corner
+	box->length			= parser.read_vector();		// length
+	box->width			= parser.read_vector();		// width
+	box->height			= parser.read_vector();		// height
 
-	box->material	= read_material( data );	// material
+	box->material	= read_material( parser );	// material
 
-	return box;
+	return box.release();
 }
 
 /**
 * @brief read polygon data
-* @param data
+* @param parser
 * @return polygon
 */
-Shapes::Polygon* Scene::read_polygon( std::string& data )
+Shapes::Polygon* Scene::read_polygon( Parser& parser )
 {
-	Shapes::Polygon* polygon = new Shapes::Polygon;
+	auto polygon = std::make_unique<Shapes::Polygon>();
 
-	int i = read_int( data );
+	const size_t start = parser.position();
+	int i = parser.read_int();
+
+	if ( i < 3 )
+		parser.error( "a polygon needs at least 3 vertices", start );
 
 	for ( ; i > 0; i-- )
-		polygon->vertices.push_back( read_vector( data ) );
+		polygon->vertices.push_back( parser.read_vector() );
 
 	auto& vertices = polygon->vertices;
 	polygon->normal = normalize( cross( vertices[1u] - vertices[0u], vertices[2u] - vertices[0u] ) );
 
-	polygon->material = read_material( data );
+	polygon->material = read_material( parser );
 
-	return polygon;
+	return polygon.release();
 }
 
 /**
 * @brief read ellipsoid data
-* @param data
+* @param parser
 * @return ellipsoid
 */
-Shapes::Ellipsoid* Scene::read_ellipsoid( std::string& data )
+Shapes::Ellipsoid* Scene::read_ellipsoid( Parser& parser )
 {
-	Shapes::Ellipsoid* ellipsoid = new Shapes::Ellipsoid;
+	auto ellipsoid = std::make_unique<Shapes::Ellipsoid>();
 
-	ellipsoid->pos = read_vector( data );
-	ellipsoid->u = read_vector( data );
-	ellipsoid->v = read_vector( data );
-	ellipsoid->w = read_vector( data );
+	ellipsoid->pos = parser.read_vector();
+	ellipsoid->u = parser.read_vector();
+	ellipsoid->v = parser.read_vector();
+	ellipsoid->w = parser.read_vector();
 
 	ellipsoid->inv_model = inverse( mat3( ellipsoid->u, ellipsoid->v, ellipsoid->w ) );
 
-	ellipsoid->material = read_material( data );
+	ellipsoid->material = read_material( parser );
 
-	return ellipsoid;
+	return ellipsoid.release();
 }
 
 /**
-* @brief read mesh data
-* @param data
+* @brief read mesh data, the geometry of an obj file is loaded once and shared by its instances
+* @param parser
 * @return mesh
 */
-Shapes::Mesh * Scene::read_mesh( std::string& data )
+Shapes::Mesh * Scene::read_mesh( Parser& parser )
 {
-	// read file_path
-	size_t new_line = data.find( '\n' );
-	size_t space = data.find( ' ' );
+	auto mesh = std::make_unique<Shapes::Mesh>();
 
-	size_t start = new_line < space ? new_line : space;
-	data = data.substr( start + 1u );
-
-	new_line = data.find( '\n' );
-	space = data.find( ' ' );
+	// read file_path
+	const std::string path( parser.read_word() );
 
-	size_t end = new_line < space ? new_line : space;
+	// geometry already used by another mesh
+	auto found = m_mesh_data.find( path );
+	if ( found != m_mesh_data.end() )
+		mesh->data = found->second;
+	else
+	{
+		std::shared_ptr<Shapes::MeshData> data = load_obj( path.c_str() );
 
-	std::string path = data.substr( 0u, end );
-	data = data.substr( end );
+		if ( data == nullptr )
+			parser.error( "couldn't open the file " + path, parser.position() - path.size() );
 
-	// read vertices
-	Shapes::Mesh* mesh = load_obj( path.c_str() );
+		m_mesh_data.emplace( path, data );
+		m_dependencies.push_back( path );
+		mesh->data = data;
+	}
 
 	// get position, rotation and scale
-	vec3 pos = read_vector( data );
-	vec3 rot = read_vector( data );
-	float scl = read_float( data );
+	vec3 pos = parser.read_vector();
+	vec3 rot = parser.read_vector();
+	float scl = parser.read_float();
 
 	// construct model to world
 	mat4 translate = glm::translate( pos );
@@ -293,103 +252,97 @@ Shapes::Mesh * Scene::read_mesh( std::string& data )
 	mat4 rot_x = glm::rotate( translate, rot.x, vec3( 1.0f, 0.0f, 0.0f ) );
 	mat4 rot_y = glm::rotate( rot_x, rot.y, vec3( 0.0f, 1.0f, 0.0f ) );
 	mat4 rot_z = glm::rotate( rot_y, rot.z, vec3( 0.0f, 0.0f, 1.0f ) );
-	mat4 model = glm::scale( rot_z, vec3( scl ) );
-
-	// transform vertices
-	for ( auto& vertex : mesh->vertices )
-		vertex = vec3( model * vec4( vertex, 1.0f ) );
-
-	// generate bounding volume
-	mesh->compute_bv();
+	mesh->model = glm::scale( rot_z, vec3( scl ) );
 
 	// read material
-	mesh->material = read_material( data );
+	mesh->material = read_material( parser );
 
-	return mesh;
+	return mesh.release();
 }
 
 /**
 * @breif read the point light data
-* @param data
+* @param parser
 * @return point light
 */
-Lights::Point Scene::read_point_light( std::string& data )
+Lights::Point Scene::read_point_light( Parser& parser )
 {
 	Lights::Point light;
 
-	light.pos		= read_vector( data );
-	light.color		= read_vector( data );
-	light.radius	= read_float ( data );
+	light.pos		= parser.read_vector();
+	light.color		= parser.read_vector();
+	light.radius	= parser.read_float();
 
 	return light;
 }
 
 /**
 * @brief read the ambient light data
-* @param data
+* @param parser
 * @return ambient light
 */
-Lights::Ambient Scene::read_ambient( std::string& data )
+Lights::Ambient Scene::read_ambient( Parser& parser )
 {
 	Lights::Ambient ambient;
 
-	ambient.color = read_vector( data );
+	ambient.color = parser.read_vector();
 
 	return ambient;
 }
 
 /**
 * @brief read the air
-* @param data
+* @param parser
 * @return air
 */
-Lights::Air Scene::read_air( std::string& data )
+Lights::Air Scene::read_air( Parser& parser )
 {
 	Lights::Air air;
 
-	air.electric_permitivity	= read_float ( data );
-	air.magnetic_permeability	= read_float ( data );
-	air.attenuation				= read_vector( data );
+	air.electric_permitivity	= parser.read_float();
+	air.magnetic_permeability	= parser.read_float();
+	air.attenuation				= parser.read_vector();
 
 	return air;
 }
 
 /**
-* @brief read camera data
-* @param data
-* @return sphere
+* @brief read camera data, optionally followed by the shape of the lense
+* @param parser
+* @return camera
 */
-Camera Scene::read_camera( std::string& data )
+Camera Scene::read_camera( Parser& parser )
 {
 	Camera camera;
 	
-	camera.center		= read_vector( data );			// center of viewport
-	camera.u			= read_vector( data );			// projection u values
-	camera.v			= read_vector( data );			// projection v values
+	camera.center		= parser.read_vector();			// center of viewport
+	camera.u			= parser.read_vector();			// projection u values
+	camera.v			= parser.read_vector();			// projection v values
     camera.w = normalize( cross( camera.u, camera.v ) );	// forward vector
 
-	camera.r			= read_float( data );			// r value
+	camera.r			= parser.read_float();			// r value
 
-	camera.aperture		= read_float( data );			// aperture
-	camera.focal_point	= read_float( data );			// focal length
+	camera.aperture		= parser.read_float();			// aperture
+	camera.focal_point	= parser.read_float();			// focal length
 	// thin lens data
-	camera.refraction_index = read_float( data );
-	camera.r1 = read_float( data );
-	camera.r2 = read_float( data );
+	camera.refraction_index = parser.read_float();
+	camera.r1 = parser.read_float();
+	camera.r2 = parser.read_float();
 
-	data = data.substr( 1u );
-	if ( data.rfind( "LENSE", 0u ) == 0u )
+	if ( parser.peek_word() == "LENSE" )
 	{
+		parser.read_word();
+
 		float total_area = 0.0f;
 
-		int i = read_int( data );
+		int i = parser.read_int();
 		for ( ; i > 0; i-- )
 		{
 			Shapes::LenseTriangle t;
 
-			t.a = read_vector2( data ) * camera.aperture;
-			t.b = read_vector2( data ) * camera.aperture;
-			t.c = read_vector2( data ) * camera.aperture;
+			t.a = parser.read_vector2() * camera.aperture;
+			t.b = parser.read_vector2() * camera.aperture;
+			t.c = parser.read_vector2() * camera.aperture;
 
 			vec2 va = t.b - t.a;
 			vec2 vb = t.c - t.a;
@@ -416,190 +369,47 @@ Camera Scene::read_camera( std::string& data )
 
 /**
 * @brief read material data of an object
-* @param data	line to parse
+* @param parser
 * @return material
 */
-Material Scene::read_material( std::string& data )
+Material Scene::read_material( Parser& parser )
 {
 	Material material;
 
-	material.diffuse_color			= read_vector( data );
-	material.specular_reflection	= read_float ( data );
-	material.specular_exponent		= read_float ( data );
-	material.attenuation			= read_vector( data );
-	material.electric_permittivity	= read_float ( data );
-	material.magnetic_permeability	= read_float ( data );
-	material.roughness				= read_float ( data );
+	material.diffuse_color			= parser.read_vector();
+	material.specular_reflection	= parser.read_float();
+	material.specular_exponent		= parser.read_float();
+	material.attenuation			= parser.read_vector();
+	material.electric_permittivity	= parser.read_float();
+	material.magnetic_permeability	= parser.read_float();
+	material.roughness				= parser.read_float();
 
 	return material;
 }
 
 /**
-* @brief read a vector from a string
-* @param data	string to read from
-* @return vector
-*/
-vec3 Scene::read_vector( std::string & data )
-{
-	vec3 vec;
-
-	vec.x = read_float( data, '(', ',' );	// x value
-	vec.y = read_float( data, ',', ',' );	// y value
-	vec.z = read_float( data, ',', ')' );	// z value
-
-	return vec;
-}
-
-/**
-* @brief read a vector from a string
-* @param data	string to read from
-* @return vector
-*/
-vec2 Scene::read_vector2( std::string & data )
-{
-	vec2 vec;
-
-	vec.x = read_float( data, '(', ',' );	// x value
-	vec.y = read_float( data, ',', ')' );	// y value
-
-	return vec;
-}
-
-/**
-* @brief read a float value from a string
-* @param data		string to read from
-* @param prev_char	character previous to the value
-* @param post_char	character right after the value
-* @return float
-*/
-float Scene::read_float( std::string& data, const char prev_char, const char post_char )
-{
-	float result;
-
-	size_t start	= data.find( prev_char );
-	data = data.substr( start + 1u );
-	size_t end		= data.find( post_char );
-
-	result = static_cast<float>( std::atof( data.substr( 0u, end ).c_str() ) );
-	data = data.substr( end );
-
-	return result;
-}
-
-/**
-* @brief read a float value from a string
-* @param data		string to read from
-* @return float
-*/
-float Scene::read_float( std::string& data )
-{
-	float result;
-
-	size_t new_line = data.find( '\n' );
-	size_t space = data.find( ' ' );
-
-	size_t start = new_line < space ? new_line : space;
-	data = data.substr( start + 1u );
-
-	new_line = data.find( '\n' );
-	space = data.find( ' ' );
-
-	size_t end = new_line < space ? new_line : space;
-
-	result = static_cast< float >( std::atof( data.substr( 0u, end ).c_str() ) );
-	data = data.substr( end );
-
-	return result;
-}
-
-/**
-* @brief read an int value from a string
-* @param data		string to read from
-* @return int
-*/
-int Scene::read_int( std::string & data )
-{
-	int result;
-
-	size_t new_line = data.find( '\n' );
-	size_t space = data.find( ' ' );
-
-	size_t start = new_line < space ? new_line : space;
-	data = data.substr( start + 1u );
-
-	new_line = data.find( '\n' );
-	space = data.find( ' ' );
-
-	size_t end = new_line < space ? new_line : space;
-
-	result = static_cast<int>( std::atof( data.substr( 0u, end ).c_str() ) );
-	data = data.substr( end );
-
-	return result;
-}
-
-/**
-* @brief read a mesh from an obj file
+* @brief read a mesh from an obj file and prepare it for rendering
 * @param file_path
+* @return geometry in the frame of the file, nullptr if the file can not be opened
+* @throw ParseError if the file has invalid data
 */
-Shapes::Mesh* Scene::load_obj( const char* file_path )
+std::shared_ptr<Shapes::MeshData> Scene::load_obj( const char* file_path )
 {
-	Shapes::Mesh* mesh = new Shapes::Mesh;
+	auto data = std::make_shared<Shapes::MeshData>();
 
-	std::ifstream file( file_path );
+	// the caller reports the error
+	Obj::Stats stats;
+	if ( Obj::load( file_path, data->vertices, data->indices, stats ) == false )
+		return nullptr;
 
-	if ( !file.is_open() )
-	{
-		std::cout << "Couldn't open the file " << file_path << std::endl;
-		std::abort();
-	}
+	m_obj_stats.add( stats );
 
-	while ( !file.eof() )
-	{
-		std::string line;
-		file >> line;
+	// generate bounding volume, triangle data and triangle hierarchy
+	data->compute_bv();
+	data->precompute_triangles();
+	data->build_bvh();
 
-		// vertex
-		if ( line == "v" )
-		{
-			vec3 vertex;
-
-			std::string val;
-			file >> val;
-			vertex.x = static_cast< float >( std::atof( val.c_str() ) );
-			file >> val;
-			vertex.y = static_cast< float >( std::atof( val.c_str() ) );
-			file >> val;
-			vertex.z = static_cast< float >( std::atof( val.c_str() ) );
-
-			mesh->vertices.push_back( vertex );
-		}
-		// face
-		else if ( line == "f" )
-		{
-			ivec3 index;
-
-			std::string val;
-			file >> val;
-			index.x = static_cast<int>( std::atof( val.c_str() ) );
-			file >> val;
-			index.y = static_cast<int>( std::atof( val.c_str() ) );
-			file >> val;
-			index.z = static_cast<int>( std::atof( val.c_str() ) );
-
-			mesh->indices.push_back( index - glm::one<ivec3>() );
-		}
-		// not relevant
-		else
-		{
-			std::string useless;
-			std::getline( file, useless );
-		}
-	}
-
-	file.close();
-
-	return mesh;
+	return data;
 }
 
 /**
@@ -646,3 +456,31 @@ const Lights::Air & Scene::air() const
 {
 	return m_air;
 }
+
+
+/**
+* @brief check if the scene should be traversed using the bvh
+* @return false to raycast every shape (brute force)
+*/
+bool Scene::use_bvh() const
+{
+	return m_use_bvh;
+}
+
+/**
+* @brief get the other files read to load the scene
+* @return paths of the obj files
+*/
+const std::vector<std::string>& Scene::dependencies() const
+{
+	return m_dependencies;
+}
+
+/**
+* @brief get the cost of loading the obj files of the scene
+* @return stats added over every mesh
+*/
+const Obj::Stats& Scene::obj_stats() const
+{
+	return m_obj_stats;
+}
\ No newline at end of file
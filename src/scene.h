@@ -11,10 +11,14 @@ Creation date: 01/08/2020
 #pragma once
 
 #include "shapes.h"
+#include "parser.h"
+#include "obj_loader.h"
 #include "light.h"
 #include "camera.h"
-#include <vector>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class Scene
 {
@@ -29,27 +33,21 @@ public:
 
 private:
 
-	void read_line( std::string& line );
+	void read_entry( Parser& parser );
 
-	Shapes::Sphere*		read_sphere			( std::string& data );
-	Shapes::Box*		read_box			( std::string& data );
-	Shapes::Polygon*	read_polygon		( std::string& data );
-	Shapes::Ellipsoid*	read_ellipsoid		( std::string& data );
-	Shapes::Mesh*		read_mesh			( std::string& data );
-	Lights::Point		read_point_light	( std::string& data );
-	Lights::Ambient		read_ambient		( std::string& data );
-	Lights::Air			read_air			( std::string& data );
-	Camera				read_camera			( std::string& data );
+	Shapes::Sphere*		read_sphere			( Parser& parser );
+	Shapes::Box*		read_box			( Parser& parser );
+	Shapes::Polygon*	read_polygon		( Parser& parser );
+	Shapes::Ellipsoid*	read_ellipsoid		( Parser& parser );
+	Shapes::Mesh*		read_mesh			( Parser& parser );
+	Lights::Point		read_point_light	( Parser& parser );
+	Lights::Ambient		read_ambient		( Parser& parser );
+	Lights::Air			read_air			( Parser& parser );
+	Camera				read_camera			( Parser& parser );
 
-	Material			read_material		( std::string& data );
+	Material			read_material		( Parser& parser );
 
-	vec3				read_vector			( std::string& data );
-	vec2				read_vector2		( std::string& data );
-	float				read_float			( std::string& data, const char prev_char, const char post_char );
-	float				read_float			( std::string& data );
-	int					read_int			( std::string& data );
-
-	Shapes::Mesh* load_obj( const char* file_path );
+	std::shared_ptr<Shapes::MeshData> load_obj( const char* file_path );
 
 public:
 	const std::vector<Shapes::Shape*>&	shapes	() const;
@@ -57,12 +55,20 @@ public:
 	const std::vector<Lights::Point>&	lights	() const;
 	const Lights::Ambient&				ambient	() const;
 	const Lights::Air&					air		() const;
+	bool								use_bvh	() const;
+	const std::vector<std::string>&		dependencies() const;
+	const Obj::Stats&					obj_stats() const;
 
 private:
 	std::vector<Shapes::Shape*>		m_shapes;
+	bool							m_use_bvh = true;	// false -> raycast every shape
 
 	std::vector<Lights::Point>		m_lights;
 	Lights::Ambient					m_ambient;
 	Lights::Air						m_air;
 	Camera							m_camera;
+
+	std::unordered_map<std::string, std::shared_ptr<Shapes::MeshData>>	m_mesh_data;	// geometry of every obj file, by path
+	std::vector<std::string>		m_dependencies;		// obj files
+	Obj::Stats						m_obj_stats;
 };
\ No newline at end of file
@@ -0,0 +1,432 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: scene_cache.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "scene_cache.h"
+#include "mapped_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace
+{
+	const char		magic[8]	= { 'C', 'S', '5', '0', '0', 'S', 'C', 'N' };
+	const size_t	alignment	= 16u;
+
+	/**
+	* @brief FNV-1a hash of a block of bytes
+	* @param data
+	* @param size
+	* @param hash	hash of the previous blocks
+	* @return hash
+	*/
+	uint64_t fnv1a( const void* data, const size_t size, uint64_t hash = 14695981039346656037ull )
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>( data );
+
+		for ( size_t i = 0u; i < size; i++ )
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	/**
+	* @brief identify the memory layout of the stored types, a different compiler or a change
+	*        in a struct gives a different value and the cache is not used
+	* @return layout key
+	*/
+	uint64_t layout_key()
+	{
+		const uint32_t sizes[] =
+		{
+			sizeof( vec3 ), sizeof( mat3 ), sizeof( Material ), sizeof( Lights::Point ), sizeof( Lights::Ambient ),
+			sizeof( Lights::Air ), sizeof( Shapes::LenseTriangle ), sizeof( BVH::Node ), sizeof( CompiledScene::Primitive )
+		};
+
+		return fnv1a( sizes, sizeof( sizes ) );
+	}
+
+	/**
+	* @brief sequential writer of the cache contents in memory
+	*/
+	class Writer
+	{
+	public:
+
+		template <typename T>
+		void value( const T& value )
+		{
+			static_assert( std::is_trivially_copyable<T>::value, "only plain data can be stored" );
+			m_data.append( reinterpret_cast<const char*>( &value ), sizeof( T ) );
+		}
+
+		// count followed by the aligned elements
+		template <typename T>
+		void array( const std::vector<T>& values )
+		{
+			static_assert( std::is_trivially_copyable<T>::value, "only plain data can be stored" );
+			value( static_cast<uint64_t>( values.size() ) );
+			m_data.resize( ( m_data.size() + alignment - 1u ) / alignment * alignment, '\0' );
+			m_data.append( reinterpret_cast<const char*>( values.data() ), values.size() * sizeof( T ) );
+		}
+
+		void string( const std::string& text )
+		{
+			array( std::vector<char>( text.begin(), text.end() ) );
+		}
+
+		const std::string& data() const
+		{
+			return m_data;
+		}
+
+	private:
+		std::string m_data;
+	};
+
+	/**
+	* @brief sequential reader of a mapped cache, any read past the end invalidates it
+	*/
+	class Reader
+	{
+	public:
+
+		Reader( const char* data, const size_t size ) :
+			m_data( data ), m_size( size )
+		{}
+
+		template <typename T>
+		bool value( T& value )
+		{
+			if ( m_valid == false || m_size - m_pos < sizeof( T ) )
+				return m_valid = false;
+
+			std::memcpy( &value, m_data + m_pos, sizeof( T ) );
+			m_pos += sizeof( T );
+			return true;
+		}
+
+		template <typename T>
+		bool array( std::vector<T>& values )
+		{
+			uint64_t count = 0u;
+			if ( value( count ) == false )
+				return false;
+
+			m_pos = ( m_pos + alignment - 1u ) / alignment * alignment;
+			if ( m_pos > m_size || count > ( m_size - m_pos ) / sizeof( T ) )
+				return m_valid = false;
+
+			const T* first = reinterpret_cast<const T*>( m_data + m_pos );
+			values.assign( first, first + count );
+			m_pos += static_cast<size_t>( count ) * sizeof( T );
+			return true;
+		}
+
+		bool string( std::string& text )
+		{
+			std::vector<char> characters;
+			if ( array( characters ) == false )
+				return false;
+
+			text.assign( characters.begin(), characters.end() );
+			return true;
+		}
+
+		bool valid() const
+		{
+			return m_valid;
+		}
+
+	private:
+		const char*	m_data;
+		size_t		m_size;
+		size_t		m_pos = 0u;
+		bool		m_valid = true;
+	};
+
+	/**
+	* @brief write the fields of a camera
+	* @param writer
+	* @param camera
+	*/
+	void write_camera( Writer& writer, const Camera& camera )
+	{
+		writer.value( camera.pos );
+		writer.value( camera.center );
+		writer.value( camera.u );
+		writer.value( camera.v );
+		writer.value( camera.w );
+		writer.value( camera.r );
+		writer.value( camera.aperture );
+		writer.value( camera.focal_point );
+		writer.value( camera.refraction_index );
+		writer.value( camera.r1 );
+		writer.value( camera.r2 );
+		writer.array( camera.lense_triangles );
+	}
+
+	/**
+	* @brief read the fields of a camera
+	* @param reader
+	* @param camera
+	* @return false if the data is truncated
+	*/
+	bool read_camera( Reader& reader, Camera& camera )
+	{
+		reader.value( camera.pos );
+		reader.value( camera.center );
+		reader.value( camera.u );
+		reader.value( camera.v );
+		reader.value( camera.w );
+		reader.value( camera.r );
+		reader.value( camera.aperture );
+		reader.value( camera.focal_point );
+		reader.value( camera.refraction_index );
+		reader.value( camera.r1 );
+		reader.value( camera.r2 );
+		return reader.array( camera.lense_triangles );
+	}
+}
+
+/**
+* @brief load a compiled scene from its cache
+* @param cache_file	path of the cache
+* @param scene_file	path of the text scene the cache was made from
+* @param scene		output scene, cleared if the cache is not used
+* @return false if there is no cache or it is out of date
+*/
+bool SceneCache::load( const char* cache_file, const char* scene_file, CompiledScene& scene )
+{
+	scene.clear();
+
+	MappedFile file( cache_file );
+	if ( file.is_open() == false )
+		return false;
+
+	Reader reader( file.data(), file.size() );
+
+	// not a cache or stored with a different format
+	char		file_magic[sizeof( magic )] = {};
+	uint32_t	file_version = 0u;
+	uint64_t	file_layout = 0u;
+	reader.value( file_magic );
+	reader.value( file_version );
+	reader.value( file_layout );
+	if ( reader.valid() == false || std::memcmp( file_magic, magic, sizeof( magic ) ) != 0 || file_version != version || file_layout != layout_key() )
+		return false;
+
+	// the scene or any of its meshes changed
+	uint64_t stored_hash = 0u;
+	uint64_t hash = 0u;
+	reader.value( stored_hash );
+	if ( reader.valid() == false || hash_file( scene_file, hash ) == false || hash != stored_hash )
+		return false;
+
+	uint64_t dependency_count = 0u;
+	reader.value( dependency_count );
+	for ( uint64_t i = 0u; i < dependency_count && reader.valid(); i++ )
+	{
+		std::string path;
+		reader.string( path );
+		reader.value( stored_hash );
+		if ( reader.valid() == false || hash_file( path.c_str(), hash ) == false || hash != stored_hash )
+			return false;
+	}
+
+	// compiled data
+	reader.array( scene.m_primitives );
+	reader.array( scene.m_materials );
+
+	reader.array( scene.m_spheres.x );
+	reader.array( scene.m_spheres.y );
+	reader.array( scene.m_spheres.z );
+	reader.array( scene.m_spheres.radius );
+	reader.array( scene.m_spheres.material );
+
+	reader.array( scene.m_boxes.min );
+	reader.array( scene.m_boxes.max );
+	reader.array( scene.m_boxes.material );
+
+	reader.array( scene.m_oriented_boxes.pos );
+	reader.array( scene.m_oriented_boxes.inv_model );
+	reader.array( scene.m_oriented_boxes.normals );
+	reader.array( scene.m_oriented_boxes.material );
+
+	reader.array( scene.m_polygons.first_triangle );
+	reader.array( scene.m_polygons.triangle_count );
+	reader.array( scene.m_polygons.normal );
+	reader.array( scene.m_polygons.material );
+
+	reader.array( scene.m_ellipsoids.pos );
+	reader.array( scene.m_ellipsoids.inv_model );
+	reader.array( scene.m_ellipsoids.material );
+
+	reader.array( scene.m_meshes.geometry );
+	reader.array( scene.m_meshes.pos );
+	reader.array( scene.m_meshes.inv_model );
+	reader.array( scene.m_meshes.material );
+
+	reader.array( scene.m_geometries.first_triangle );
+	scene.m_geometries.bvh.resize( scene.m_geometries.first_triangle.size() );
+	for ( auto& bvh : scene.m_geometries.bvh )
+	{
+		reader.array( bvh.m_nodes );
+		reader.array( bvh.m_primitives );
+	}
+
+	reader.array( scene.m_triangles.origin );
+	reader.array( scene.m_triangles.edge1 );
+	reader.array( scene.m_triangles.edge2 );
+	reader.array( scene.m_triangles.normal );
+	reader.array( scene.m_triangles.normal_length );
+
+	reader.array( scene.m_bvh.m_nodes );
+	reader.array( scene.m_bvh.m_primitives );
+	reader.value( scene.m_use_bvh );
+
+	reader.array( scene.m_lights );
+	reader.value( scene.m_ambient );
+	reader.value( scene.m_air );
+	read_camera( reader, scene.m_camera );
+
+	if ( reader.valid() == false )
+	{
+		scene.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/**
+* @brief save a compiled scene to a cache
+* @param cache_file		path of the cache
+* @param scene_file		path of the text scene the scene was compiled from
+* @param dependencies	other files used by the scene (obj files)
+* @param scene
+* @return false if a file could not be read or written
+*/
+bool SceneCache::save( const char* cache_file, const char* scene_file, const std::vector<std::string>& dependencies, const CompiledScene& scene )
+{
+	Writer writer;
+
+	writer.value( magic );
+	writer.value( static_cast<uint32_t>( version ) );
+	writer.value( layout_key() );
+
+	// hashes of the sources
+	uint64_t hash = 0u;
+	if ( hash_file( scene_file, hash ) == false )
+		return false;
+	writer.value( hash );
+
+	writer.value( static_cast<uint64_t>( dependencies.size() ) );
+	for ( const auto& path : dependencies )
+	{
+		if ( hash_file( path.c_str(), hash ) == false )
+			return false;
+		writer.string( path );
+		writer.value( hash );
+	}
+
+	// compiled data
+	writer.array( scene.m_primitives );
+	writer.array( scene.m_materials );
+
+	writer.array( scene.m_spheres.x );
+	writer.array( scene.m_spheres.y );
+	writer.array( scene.m_spheres.z );
+	writer.array( scene.m_spheres.radius );
+	writer.array( scene.m_spheres.material );
+
+	writer.array( scene.m_boxes.min );
+	writer.array( scene.m_boxes.max );
+	writer.array( scene.m_boxes.material );
+
+	writer.array( scene.m_oriented_boxes.pos );
+	writer.array( scene.m_oriented_boxes.inv_model );
+	writer.array( scene.m_oriented_boxes.normals );
+	writer.array( scene.m_oriented_boxes.material );
+
+	writer.array( scene.m_polygons.first_triangle );
+	writer.array( scene.m_polygons.triangle_count );
+	writer.array( scene.m_polygons.normal );
+	writer.array( scene.m_polygons.material );
+
+	writer.array( scene.m_ellipsoids.pos );
+	writer.array( scene.m_ellipsoids.inv_model );
+	writer.array( scene.m_ellipsoids.material );
+
+	writer.array( scene.m_meshes.geometry );
+	writer.array( scene.m_meshes.pos );
+	writer.array( scene.m_meshes.inv_model );
+	writer.array( scene.m_meshes.material );
+
+	writer.array( scene.m_geometries.first_triangle );
+	for ( const auto& bvh : scene.m_geometries.bvh )
+	{
+		writer.array( bvh.m_nodes );
+		writer.array( bvh.m_primitives );
+	}
+
+	writer.array( scene.m_triangles.origin );
+	writer.array( scene.m_triangles.edge1 );
+	writer.array( scene.m_triangles.edge2 );
+	writer.array( scene.m_triangles.normal );
+	writer.array( scene.m_triangles.normal_length );
+
+	writer.array( scene.m_bvh.m_nodes );
+	writer.array( scene.m_bvh.m_primitives );
+	writer.value( scene.m_use_bvh );
+
+	writer.array( scene.m_lights );
+	writer.value( scene.m_ambient );
+	writer.value( scene.m_air );
+	write_camera( writer, scene.m_camera );
+
+	// written aside and renamed, another run never maps a half written cache
+	const std::string temporary = std::string( cache_file ) + ".tmp";
+	std::ofstream file( temporary, std::ios::binary | std::ios::trunc );
+	if ( !file )
+		return false;
+
+	file.write( writer.data().data(), writer.data().size() );
+	file.close();
+
+	if ( !file )
+	{
+		std::remove( temporary.c_str() );
+		return false;
+	}
+
+	std::remove( cache_file );
+	return std::rename( temporary.c_str(), cache_file ) == 0;
+}
+
+/**
+* @brief hash the contents of a file
+* @param file_path
+* @param hash		output FNV-1a hash
+* @return false if the file can not be read
+*/
+bool SceneCache::hash_file( const char* file_path, uint64_t& hash )
+{
+	MappedFile file( file_path );
+	if ( file.is_open() == false )
+		return false;
+
+	hash = fnv1a( file.data(), file.size() );
+	return true;
+}
@@ -0,0 +1,36 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: scene_cache.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "compiled_scene.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+* @brief binary copy of a compiled scene, to skip parsing, loading meshes and building hierarchies
+*
+* The file starts with a header (format version, size of the stored types) and the FNV-1a hash
+* of the scene file and of every obj file it references. The arrays of the compiled scene follow
+* as raw bytes, each one aligned to 16 bytes from the start of the file, so the mapped file is
+* read with one bulk copy per array. A cache is only used when every hash still matches.
+*/
+class SceneCache
+{
+public:
+
+	static const uint32_t version = 2u;
+
+	static bool load( const char* cache_file, const char* scene_file, CompiledScene& scene );
+	static bool save( const char* cache_file, const char* scene_file, const std::vector<std::string>& dependencies, const CompiledScene& scene );
+
+	static bool hash_file( const char* file_path, uint64_t& hash );
+};
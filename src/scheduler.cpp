@@ -0,0 +1,111 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: scheduler.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "scheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+/**
+* @brief split the image in tiles and distribute them between the threads
+* @param width			image width
+* @param height			image height
+* @param tile_size		side of the tiles in pixels
+* @param thread_count	amount of threads that will ask for tiles
+*/
+TileScheduler::TileScheduler( const int width, const int height, const int tile_size, const unsigned thread_count )
+{
+	const unsigned queue_count = std::max( thread_count, 1u );
+	for ( unsigned i = 0u; i < queue_count; i++ )
+		m_queues.emplace_back( new Queue );
+
+	// tiles in scanline order
+	std::vector<Tile> tiles;
+	for ( int y = 0; y < height; y += tile_size )
+	{
+		for ( int x = 0; x < width; x += tile_size )
+			tiles.push_back( { x, y, std::min( tile_size, width - x ), std::min( tile_size, height - y ) } );
+	}
+	m_tile_count = static_cast<unsigned>( tiles.size() );
+
+	// each thread gets a contiguous block so neighbouring tiles stay in the same thread
+	for ( unsigned i = 0u; i < queue_count; i++ )
+	{
+		size_t begin = tiles.size() * i / queue_count;
+		size_t end = tiles.size() * ( i + 1u ) / queue_count;
+		m_queues[i]->tiles.assign( tiles.begin() + begin, tiles.begin() + end );
+	}
+}
+
+/**
+* @brief get the next tile to render
+* @param thread_id	id of the thread asking
+* @param tile		next tile (return)
+* @return false when there is no work left
+*/
+bool TileScheduler::next_tile( const unsigned thread_id, Tile& tile )
+{
+	const unsigned queue_count = static_cast<unsigned>( m_queues.size() );
+
+	// own work first
+	{
+		Queue& queue = *m_queues[thread_id];
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		if ( queue.tiles.empty() == false )
+		{
+			tile = queue.tiles.front();
+			queue.tiles.pop_front();
+			return true;
+		}
+	}
+
+	// steal from the back of the other threads
+	for ( unsigned i = 1u; i < queue_count; i++ )
+	{
+		Queue& victim = *m_queues[( thread_id + i ) % queue_count];
+		std::lock_guard<std::mutex> lock( victim.mutex );
+		if ( victim.tiles.empty() == false )
+		{
+			tile = victim.tiles.back();
+			victim.tiles.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+* @brief get the amount of threads the tiles are distributed between
+* @return thread count
+*/
+unsigned TileScheduler::thread_count() const
+{
+	return static_cast<unsigned>( m_queues.size() );
+}
+
+/**
+* @brief get the total amount of tiles
+* @return tile count
+*/
+unsigned TileScheduler::tile_count() const
+{
+	return m_tile_count;
+}
+
+/**
+* @brief get the amount of hardware threads, at least one
+* @return thread count
+*/
+unsigned TileScheduler::hardware_threads()
+{
+	unsigned count = std::thread::hardware_concurrency();
+	return count == 0u ? 1u : count;
+}
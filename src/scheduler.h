@@ -0,0 +1,53 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: scheduler.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Tile
+{
+	int x, y;			// first pixel (column, row)
+	int width, height;	// size in pixels
+};
+
+/**
+* @brief splits the image in tiles and hands them to the threads
+*
+* Each thread owns a deque with a contiguous block of tiles that it takes from the front.
+* When it runs out it steals from the back of the deque of another thread.
+*/
+class TileScheduler
+{
+public:
+
+	TileScheduler( const int width, const int height, const int tile_size, const unsigned thread_count );
+
+	bool next_tile( const unsigned thread_id, Tile& tile );
+
+	unsigned thread_count() const;
+	unsigned tile_count() const;
+
+	static unsigned hardware_threads();
+
+private:
+
+	struct Queue
+	{
+		std::mutex			mutex;
+		std::deque<Tile>	tiles;
+	};
+
+	std::vector<std::unique_ptr<Queue>>	m_queues;
+	unsigned							m_tile_count;
+};
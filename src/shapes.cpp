@@ -10,111 +10,103 @@ Creation date: 01/07/2020
 
 #include "shapes.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace Shapes
 {
-	//--------------- PLANE ------------------//
+	//--------------- AABB -------------------//
 
 	/**
-	* @brief plane constructor
+	* @brief empty bounding box constructor
 	*/
-	Plane::Plane( const vec3& point, const vec3& normal ) :
-		point( point ), normal( normal )
+	AABB::AABB() :
+		min(  std::numeric_limits<float>::max() ),
+		max( -std::numeric_limits<float>::max() )
 	{}
 
 	/**
-	* @brief compute the intersection between a ray and a plane
-	* @param ray	the ray
-	* @return time of the intersection
+	* @brief bounding box constructor
+	* @param min	minimum corner
+	* @param max	maximum corner
 	*/
-	float Plane::intersect( const Ray& ray ) const 
-	{
-		float div = dot( ray.dir, normal );
-
-		// no collision
-		if ( div == 0.0f ) return -1.0f;
+	AABB::AABB( const vec3& min, const vec3& max ) :
+		min( min ), max( max )
+	{}
 
-		// -(P-C)*n/(d*n)
-		return -dot( ray.pos - point, normal ) / div;
+	/**
+	* @brief grow the box to contain a point
+	* @param point
+	*/
+	void AABB::extend( const vec3& point )
+	{
+		min = glm::min( min, point );
+		max = glm::max( max, point );
 	}
 
-
-
-
-	//--------------- TRIANGLE ---------------//
-
 	/**
-	* @brief triangle constructor
+	* @brief grow the box to contain another box
+	* @param other
 	*/
-	Triangle::Triangle( const vec3& a, const vec3& b, const vec3& c ) :
-		a( a ), b( b ), c( c )
+	void AABB::extend( const AABB& other )
 	{
-		normal = normalize( cross( b - a, c - a ) );
+		min = glm::min( min, other.min );
+		max = glm::max( max, other.max );
 	}
 
 	/**
-	* @brief compute the intersection between a ray and a triangle
-	* @param ray	the ray
-	* @param point		point of intersection (return)
-	* @return time of the intersection
+	* @brief get the center of the box
+	* @return center
 	*/
-	float Triangle::intersect( const Ray& ray, vec3& point ) const
+	vec3 AABB::center() const
 	{
-		float div = dot( normal, ray.dir );
-
-		// check
-		if ( glm::abs( div ) < 0.01f )
-			return -1.0f;
-
-		// time of collision
-		float time = ( dot( normal, a ) - dot( normal, ray.pos ) ) / div;
-
-		// check
-		if ( time < 0.0f )
-			return -1.0f;
+		return ( min + max ) * 0.5f;
+	}
 
-		point = ray.pos + time * ray.dir;
+	/**
+	* @brief compute the surface area of the box
+	* @return area (zero for empty boxes)
+	*/
+	float AABB::surface_area() const
+	{
+		vec3 extent = max - min;
 
-		// out of bounds
-		if ( is_point_inside( point ) == false )
-			return -1.0f;
+		if ( extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f )
+			return 0.0f;
 
-		return time;
+		return 2.0f * ( extent.x * extent.y + extent.y * extent.z + extent.z * extent.x );
 	}
 
 	/**
-	* @brief check if the point is inside the boundaries of the polygon
-	* @param point
-	* @return true if it is inside
+	* @brief slab test between a ray and the box
+	* @param ray_pos	start point of the ray
+	* @param inv_dir	inverse of the ray direction
+	* @param t_max		maximum time accepted
+	* @param t_entry	time at which the ray enters the box (return)
+	* @return true if the ray overlaps the box in [0, t_max]
 	*/
-	bool Triangle::is_point_inside( const vec3& point ) const
+	bool AABB::intersect( const vec3& ray_pos, const vec3& inv_dir, const float t_max, float& t_entry ) const
 	{
-		vec3 v0 = b - a;
-		vec3 v1 = c - a;
-		vec3 v2 = point - a;
-
-		float v0v0 = dot( v0, v0 );
-		float v0v1 = dot( v0, v1 );
-		float v1v1 = dot( v1, v1 );
-		float uv0 = dot( v2, v0 );
-		float uv1 = dot( v2, v1 );
+		float t_near = 0.0f;
+		float t_far = t_max;
 
-		float div = v0v0 * v1v1 - v0v1 * v0v1;
-
-		// check
-		if ( div == 0 )
-			return false;
+		for ( int i = 0; i < 3; i++ )
+		{
+			float t0 = ( min[i] - ray_pos[i] ) * inv_dir[i];
+			float t1 = ( max[i] - ray_pos[i] ) * inv_dir[i];
 
-		vec3 coordinates;
+			if ( t0 > t1 )
+				std::swap( t0, t1 );
 
-		// set the coordinates result
-		coordinates.y = ( v1v1 * uv0 - v0v1 * uv1 ) / div;
-		coordinates.z = ( v0v0 * uv1 - v0v1 * uv0 ) / div;
-		coordinates.x = 1 - coordinates.y - coordinates.z;
+			// comparisons are written so that NaN values keep the previous interval
+			t_near	= t0 > t_near ? t0 : t_near;
+			t_far	= t1 < t_far  ? t1 : t_far;
 
-		// check boundaries
-		if ( coordinates.x < 0 || coordinates.y < 0 || coordinates.z < 0 )
-			return false;
+			if ( t_near > t_far )
+				return false;
+		}
 
+		t_entry = t_near;
 		return true;
 	}
 
@@ -125,11 +117,12 @@ namespace Shapes
 
 	/**
 	* @brief get a random uniformly distributed point in the triangle
+	* @param sample	two uniform values in [0, 1)
 	*/
-	vec2 LenseTriangle::get_rand_point() const
+	vec2 LenseTriangle::get_rand_point( const vec2& sample ) const
 	{
-		float r1 = rand() / static_cast<float>( RAND_MAX );
-		float r2 = rand() / static_cast<float>( RAND_MAX );
+		float r1 = sample.x;
+		float r2 = sample.y;
 		r1 = sqrt( r1 );
 
 		vec2 result = ( 1.0f - r1 ) * a + r1 * ( 1.0f - r2 ) * b + r1 * r2 * c;
@@ -143,44 +136,12 @@ namespace Shapes
 	//--------------- SPHERE -----------------//
 
 	/**
-	* @brief compute the intersection between a ray and a sphere
-	* @param ray	the ray
-	* @return contact information of the intersection
+	* @brief compute the bounding box of the sphere
+	* @return bounding box
 	*/
-	Intersection::Contact Sphere::intersect( const Ray& ray ) const 
+	AABB Sphere::bounds() const
 	{
-		vec3 v = ray.pos - pos;
-
-		float a = dot( ray.dir, ray.dir );
-		float b = 2.0f * dot( ray.dir, v );
-		float c = dot( v, v ) - radius * radius;
-
-		float disc = b * b - 4.0f * a * c;
-
-		if ( disc < 0.0f )
-			return Intersection::Contact();
-
-		float t;
-
-		// compute the time values for the intersection
-		float t1 = ( -b + sqrt( disc ) ) / ( 2 * a );
-		float t2 = ( -b - sqrt( disc ) ) / ( 2 * a );
-
-		// the sphere is behind
-		if ( t1 < 0.0f )
-			return Intersection::Contact();
-		// the ray starts inside
-		else if ( t2 < 0.0f )
-			t = t1;
-		// the sphere is in front
-		else
-			t = t2;
-
-		// return the intersection value
-		vec3 point = ray.pos + t * ray.dir;
-		vec3 normal = normalize( point - pos );
-		Intersection::Contact contact( t, point, normal, material );
-		return contact;
+		return AABB( pos - vec3( radius ), pos + vec3( radius ) );
 	}
 
 
@@ -189,75 +150,40 @@ namespace Shapes
 	//--------------- BOX --------------------//
 
 	/**
-	* @brief generate the planes of the boxel
+	* @brief check if the edges of the box follow the world axes
+	* @return true if every edge has a single non zero coordinate
 	*/
-	void Box::generate_planes()
+	bool Box::is_axis_aligned() const
 	{
-		planes[static_cast< unsigned >( plane::front )]		= Plane( pos,			normalize( cross( length, height ) ) );
-		planes[static_cast< unsigned >( plane::back )]		= Plane( pos + width,	normalize( cross( height, length ) ) );
-		planes[static_cast< unsigned >( plane::left )]		= Plane( pos,			normalize( cross( height, width  ) ) );
-		planes[static_cast< unsigned >( plane::right )]		= Plane( pos + length,	normalize( cross( width,  height ) ) );
-		planes[static_cast< unsigned >( plane::bottom )]	= Plane( pos,			normalize( cross( width,  length ) ) );
-		planes[static_cast< unsigned >( plane::top )]		= Plane( pos + height,	normalize( cross( length, width  ) ) );
+		for ( const vec3& edge : { length, width, height } )
+		{
+			int non_zero = ( edge.x != 0.0f ) + ( edge.y != 0.0f ) + ( edge.z != 0.0f );
+			if ( non_zero != 1 )
+				return false;
+		}
+
+		return true;
 	}
 
 	/**
-	* @brief compute the intersection between a ray and a box
-	* @param ray	the ray
-	* @return contact information of the intersection
+	* @brief compute the bounding box of the box
+	* @return bounding box
 	*/
-	Intersection::Contact Box::intersect( const Ray& ray ) const 
+	AABB Box::bounds() const
 	{
-		const float min = 0.0f;
-		const float max = std::numeric_limits<float>::max();
-		float t_min = min;
-		float t_max = max;
-
-		vec3 point_min;
-		vec3 normal_min;
-		vec3 point_max;
-		vec3 normal_max;
+		AABB result;
 
-		for ( unsigned i = 0u; i < 6u; i++ )
+		for ( unsigned i = 0u; i < 8u; i++ )
 		{
-			const auto& plane = planes[i];
-
-			float dot_normal = dot( ray.dir, plane.normal );
-
-			// check front face or backface and update the values of t
-			if ( dot_normal < 0.0f )
-			{
-				float t = plane.intersect( ray );
-				if ( t > t_min )
-				{
-					t_min = t;
-					point_min = ray.pos + t * ray.dir;
-					normal_min = plane.normal;
-				}
-			}
-			else if ( dot_normal > 0.0f )
-			{
-				float t = plane.intersect( ray ); 
-				if ( t < t_max )
-				{
-					t_max = t;
-					point_max = ray.pos + t * ray.dir;
-					normal_max = plane.normal;
-				}
-			}
-			else if ( dot( ray.pos - plane.point, plane.normal ) > 0.0f )
-				return Intersection::Contact();
-		}
+			vec3 corner = pos;
+			if ( i & 1u ) corner += length;
+			if ( i & 2u ) corner += width;
+			if ( i & 4u ) corner += height;
 
-		if ( t_max >= t_min )
-		{
-			if ( t_min == min )
-				return Intersection::Contact( t_max, point_max, normal_max, material );
-			else
-				return Intersection::Contact( t_min, point_min, normal_min, material );
+			result.extend( corner );
 		}
 
-		return Intersection::Contact();
+		return result;
 	}
 
 
@@ -266,26 +192,17 @@ namespace Shapes
 	//--------------- POLYGON ----------------//
 
 	/**
-	* @brief compute the intersection between a ray and a polygon
-	* @param ray	the ray
-	* @return contact information of the intersection
+	* @brief compute the bounding box of the polygon
+	* @return bounding box
 	*/
-	Intersection::Contact Polygon::intersect( const Ray& ray ) const
+	AABB Polygon::bounds() const
 	{
-		vec3 a = vertices[0u];
-
-		for ( unsigned i = 1u; i < vertices.size() - 1u; i++ )
-		{
-			Triangle triangle( a, vertices[i], vertices[i + 1u] );
-			vec3 point;
-			float time = triangle.intersect( ray, point );
+		AABB result;
 
-			if ( time != -1.0f )
-				return Intersection::Contact( time, point, normal, material );
-		}
-			
+		for ( const auto& vertex : vertices )
+			result.extend( vertex );
 
-		return Intersection::Contact();
+		return result;
 	}
 
 
@@ -294,121 +211,98 @@ namespace Shapes
 	//--------------- ELLIPSOID --------------//
 
 	/**
-	* @brief compute the intersection between a ray and an ellipsoid
-	* @param ray	the ray
-	* @return contact information of the intersection
+	* @brief compute the bounding box of the ellipsoid
+	* @return bounding box
 	*/
-	Intersection::Contact Ellipsoid::intersect( const Ray& ray ) const
+	AABB Ellipsoid::bounds() const
 	{
-		vec3 p0 = inv_model * ( ray.pos - pos );
-		vec3 ray_dir = inv_model * ray.dir;
+		// the extent in each axis is the length of the matching row of the model matrix
+		vec3 extent(
+			sqrt( u.x * u.x + v.x * v.x + w.x * w.x ),
+			sqrt( u.y * u.y + v.y * v.y + w.y * w.y ),
+			sqrt( u.z * u.z + v.z * v.z + w.z * w.z ) );
 
-		float a = dot( ray_dir, ray_dir );
-		float b = 2.0f * dot( p0, ray_dir );
-		float c = dot( p0, p0 ) - 1.0f;
-
-		float disc = b * b - 4.0f * a * c;
+		return AABB( pos - extent, pos + extent );
+	}
 
-		if ( disc < 0.0f )
-			return Intersection::Contact();
 
-		float t;
 
-		// compute the time values for the intersection
-		float t1 = ( -b + sqrt( disc ) ) / ( 2.0f * a );
-		float t2 = ( -b - sqrt( disc ) ) / ( 2.0f * a );
 
-		// the sphere is behind
-		if ( t1 < 0.0f )
-			return Intersection::Contact();
-		// the ray starts inside
-		else if ( t2 < 0.0f )
-			t = t1;
-		// the sphere is in front
-		else
-			t = t2;
+	//--------------- MESH --------------------//
 
-		// intersection values
-		vec3 point_unit = p0 + t * ray_dir;
-		vec3 normal = normalize( transpose( inv_model ) * point_unit );
-		vec3 point = ray.pos + t * ray.dir;
+	/**
+	* @brief generate the bounding volume of the mesh
+	*/
+	void MeshData::compute_bv()
+	{
+		bounding_volume = AABB();
 
-		Intersection::Contact contact( t, point, normal, material );
-		return contact;
+		for ( const auto& vertex : vertices )
+			bounding_volume.extend( vertex );
 	}
 
+	/**
+	* @brief store the edges and normal of every triangle so they are not recomputed per ray
+	*/
+	void MeshData::precompute_triangles()
+	{
+		const size_t count = indices.size();
 
+		triangles.origin.resize( count );
+		triangles.edge1.resize( count );
+		triangles.edge2.resize( count );
+		triangles.normal.resize( count );
+		triangles.normal_length.resize( count );
 
+		for ( unsigned i = 0u; i < count; i++ )
+		{
+			const vec3& a = vertices[indices[i][0]];
+			const vec3& b = vertices[indices[i][1]];
+			const vec3& c = vertices[indices[i][2]];
 
-	//--------------- MESH --------------------//
+			vec3 normal = cross( b - a, c - a );
+
+			triangles.origin[i]			= a;
+			triangles.edge1[i]			= b - a;
+			triangles.edge2[i]			= c - a;
+			triangles.normal_length[i]	= length( normal );
+			triangles.normal[i]			= triangles.normal_length[i] > 0.0f ? normal / triangles.normal_length[i] : vec3( 0.0f );
+		}
+	}
 
 	/**
-	* @brief generate the bounding volume of the mesh
+	* @brief build the hierarchy over the triangles of the mesh
 	*/
-	void Mesh::compute_bv()
+	void MeshData::build_bvh()
 	{
-		vec3 min(  std::numeric_limits<float>::max() );
-		vec3 max( -std::numeric_limits<float>::max() );
+		std::vector<AABB> bounds( indices.size() );
 
-		for ( const auto vertex : vertices )
+		for ( unsigned i = 0u; i < indices.size(); i++ )
 		{
-			// min
-			min.x = vertex.x < min.x ? vertex.x : min.x;
-			min.y = vertex.y < min.y ? vertex.y : min.y;
-			min.z = vertex.z < min.z ? vertex.z : min.z;
-
-			// max
-			max.x = vertex.x > max.x ? vertex.x : max.x;
-			max.y = vertex.y > max.y ? vertex.y : max.y;
-			max.z = vertex.z > max.z ? vertex.z : max.z;
+			bounds[i].extend( vertices[indices[i][0]] );
+			bounds[i].extend( vertices[indices[i][1]] );
+			bounds[i].extend( vertices[indices[i][2]] );
 		}
 
-		bounding_volume.pos = vec3( min.x, min.y, min.z );
-
-		bounding_volume.width	= vec3( max.x - min.x, 0.0f, 0.0f );
-		bounding_volume.height	= vec3( 0.0f, max.y - min.y, 0.0f );
-		bounding_volume.length	= vec3( 0.0f, 0.0f, max.z - min.z );
-		bounding_volume.generate_planes();
+		bvh.build( bounds );
 	}
 
 	/**
-	* @brief compute the intersection between a ray and a mesh
-	* @param ray	the ray
-	* @return contact information of the intersection
+	* @brief compute the bounding box of the mesh in the world
+	* @return bounding box of the transformed bounding volume of the geometry
 	*/
-	Intersection::Contact Mesh::intersect( const Ray& ray ) const
+	AABB Mesh::bounds() const
 	{
-		// check collision with bounding volume
-		Intersection::Contact contact_bv = bounding_volume.intersect( ray );
-
-		if ( contact_bv.time == -1.0f )
-			return Intersection::Contact();
-		//else
-		//	return contact_bv;
-
+		const AABB& local = data->bounding_volume;
+		AABB bounds;
 
-		// check collision with mesh
-		vec3 point;
-		vec3 normal;
-		float time = -1.0f;
-
-		// check collision against each triangle in the mesh
-		for ( unsigned i = 0u; i < indices.size(); i++ )
+		for ( int corner = 0; corner < 8; corner++ )
 		{
-			vec3 point_curr;
-			vec3 normal_curr = normalize( cross( vertices[indices[i][1]] - vertices[indices[i][0]], vertices[indices[i][2]] - vertices[indices[i][0]] ) );
-
-			Triangle triangle( vertices[indices[i][0]], vertices[indices[i][1]], vertices[indices[i][2]] );
-			float time_curr = triangle.intersect( ray, point_curr );
-
-			if ( time_curr != -1.0f && ( time == -1.0f || time_curr < time ) )
-			{
-				point = point_curr;
-				normal = normal_curr;
-				time = time_curr;
-			}
+			vec3 point( corner & 1 ? local.max.x : local.min.x, corner & 2 ? local.max.y : local.min.y, corner & 4 ? local.max.z : local.min.z );
+			bounds.extend( vec3( model * vec4( point, 1.0f ) ) );
 		}
-		return Intersection::Contact( time, point, normal, material );
+
+		return bounds;
 	}
 
 
@@ -422,7 +316,7 @@ namespace Shapes
 	* @param dir	direction of the ray
 	*/
 	Ray::Ray( const vec3& pos, const vec3& dir )  :
-		pos( pos ), dir( dir )
+		pos( pos ), dir( dir ), inv_dir( 1.0f / dir )
 	{}
 	
 }
@@ -10,58 +10,29 @@ Creation date: 01/07/2020
 
 #pragma once
 
-#include "intersection.h"
+#include "ray.h"
+#include "aabb.h"
+#include "bvh.h"
 #include "material.h"
 #include "math_utils.h"
-#include <array>
+#include <memory>
 #include <vector>
 
 namespace Shapes
 {
-	struct Ray
-	{
-		vec3	pos;
-		vec3	dir;
-
-		Ray() = default;
-		Ray( const vec3& pos, const vec3& dir );
-	};
-
 	struct Shape
 	{
-		virtual Intersection::Contact intersect( const Ray& ray ) const = 0;
+		virtual ~Shape() = default;
+		virtual AABB bounds() const = 0;
 		Material material;
 	};
 
-	struct Plane
-	{
-		vec3 point;
-		vec3 normal;
-
-		Plane() = default;
-		Plane( const vec3& point, const vec3& normal );
-
-		float intersect( const Ray& ray ) const;
-	};
-
-	struct Triangle
-	{
-		vec3 a, b, c;
-		vec3 normal;
-
-		Triangle() = default;
-		Triangle( const vec3& a, const vec3& b, const vec3& c );
-		
-		float intersect( const Ray& ray, vec3& point  ) const;
-		bool is_point_inside( const vec3& point ) const;
-	};
-
 	struct LenseTriangle
 	{
 		vec2 a, b, c;
 		float area_euristic;
 
-		vec2 get_rand_point() const;
+		vec2 get_rand_point( const vec2& sample ) const;
 	};
 
 	struct Sphere : public Shape
@@ -69,20 +40,16 @@ namespace Shapes
 		vec3	pos;
 		float	radius;
 
-		Intersection::Contact intersect( const Ray& ray ) const;
+		AABB bounds() const;
 	};
 
 	struct Box : public Shape
 	{
 		vec3 pos;
 		vec3 length, width, height;
-		std::array<Plane, 6> planes;
-
-		enum class plane { front, back, left, right, bottom, top };
-
-		void generate_planes();
 
-		Intersection::Contact intersect( const Ray& ray ) const;
+		bool is_axis_aligned() const;
+		AABB bounds() const;
 	};
 
 	struct Polygon : public Shape
@@ -90,7 +57,7 @@ namespace Shapes
 		std::vector<vec3> vertices;
 		vec3 normal;
 
-		Intersection::Contact intersect( const Ray& ray ) const;
+		AABB bounds() const;
 	};
 
 	struct Ellipsoid : public Shape
@@ -99,18 +66,41 @@ namespace Shapes
 		vec3 u, v, w;
 		mat3 inv_model;
 
-		Intersection::Contact intersect( const Ray& ray ) const;
+		AABB bounds() const;
 	};
 
-	struct Mesh : public Shape
+	// precomputed data of a set of triangles, one entry per triangle in each array
+	struct TriangleData
+	{
+		std::vector<vec3>	origin;			// first vertex
+		std::vector<vec3>	edge1;			// second vertex - first vertex
+		std::vector<vec3>	edge2;			// third vertex - first vertex
+		std::vector<vec3>	normal;			// unit face normal
+		std::vector<float>	normal_length;	// length of cross( edge1, edge2 )
+	};
+
+	// geometry of an obj file in its own frame, shared by every mesh that uses the file
+	struct MeshData
 	{
 		std::vector<vec3>	vertices;
 		std::vector<ivec3>	indices;
 
 
-		Box bounding_volume;
+		AABB bounding_volume;
+		BVH bvh;	// hierarchy over the triangles in indices
+		TriangleData triangles;
 
 		void compute_bv();
-		Intersection::Contact intersect( const Ray& ray ) const;
+		void precompute_triangles();
+		void build_bvh();
+	};
+
+	// instance of a mesh placed in the scene
+	struct Mesh : public Shape
+	{
+		std::shared_ptr<const MeshData>	data;
+		mat4							model;	// object to world
+
+		AABB bounds() const;
 	};
 }
@@ -0,0 +1,975 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: wavefront.cpp
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#include "wavefront.h"
+#include "sampling.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	// camera rays of a wave
+	const size_t wave_size = 1u << 15u;
+
+	// rays or shadow entries a batch of contacts can spawn, the bounces are shaded in batches below it
+	const size_t batch_budget = 1u << 16u;
+
+	// smaller ranges are not worth a thread
+	const size_t min_range_size = 256u;
+
+	// rough reflection directions mapped together
+	const int reflection_batch = 16;
+
+	// rays waiting for the extend stage, one array per field
+	struct RayQueue
+	{
+		std::vector<float>				pos_x, pos_y, pos_z;
+		std::vector<float>				dir_x, dir_y, dir_z;
+		std::vector<vec3>				weight;			// fraction of the light of the ray that reaches the pixel
+		std::vector<float>				e_permittivity;	// medium the ray travels through
+		std::vector<float>				m_permeability;
+		std::vector<unsigned>			pixel;
+		std::vector<int>				depth;
+		std::vector<Random>				rng;			// sequence of the ray, forked for the rays it spawns
+		std::vector<unsigned>			sample;			// camera sample of the pixel
+		std::vector<unsigned>			dimension;		// next sampler dimension of the camera sample
+		std::vector<Intersection::Hit>	hits;			// closest hit, filled by the extend stage
+
+		size_t		size	() const { return pixel.size(); }
+		void		resize	( const size_t count );
+		void		clear	();
+		void		push	( const Shapes::Ray& ray, const vec3& ray_weight, const float e, const float m, const unsigned ray_pixel, const int ray_depth, const Random& ray_rng, const unsigned ray_sample, const unsigned ray_dimension );
+		void		set		( const size_t i, const Shapes::Ray& ray, const vec3& ray_weight, const float e, const float m, const unsigned ray_pixel, const int ray_depth, const Random& ray_rng, const unsigned ray_sample, const unsigned ray_dimension );
+		void		append	( const RayQueue& other );
+		void		assign	( const RayQueue& other, const size_t begin, const size_t end );
+		Shapes::Ray	ray		( const size_t i ) const;
+	};
+
+	// rays of one bounce, shaded a batch at a time, the rays of each batch are finished before the next one
+	struct Bounce
+	{
+		RayQueue	rays;
+		size_t		next = 0u;	// first ray of the next batch
+	};
+
+	// light reaching a contact, added to its pixel by the accumulate stage if nothing blocks it
+	struct ShadowQueue
+	{
+		std::vector<float>		pos_x, pos_y, pos_z;
+		std::vector<float>		dir_x, dir_y, dir_z;
+		std::vector<float>		t_max;		// distance to the light, 0 for light that is not blocked (ambient)
+		std::vector<vec3>		color;
+		std::vector<unsigned>	pixel;
+		std::vector<char>		visible;	// filled by the connect stage
+
+		size_t		size	() const { return pixel.size(); }
+		void		clear	();
+		void		push	( const Shapes::Ray& ray, const float distance, const vec3& light, const unsigned light_pixel );
+		void		append	( const ShadowQueue& other );
+		Shapes::Ray	ray		( const size_t i ) const;
+	};
+
+	/**
+	* @brief threads of a render, started once and woken by every stage
+	*
+	* A stage splits its queue in ranges, the caller takes the first one and each worker the range of
+	* its index, then the caller waits for all of them. The threads sleep between the stages.
+	*/
+	class WorkerPool
+	{
+	public:
+
+		explicit WorkerPool( const unsigned thread_count );
+		~WorkerPool();
+
+		template <typename Function>
+		size_t for_each_range( const size_t count, const Function& function );
+
+		unsigned thread_count() const { return static_cast<unsigned>( m_threads.size() ) + 1u; }
+
+	private:
+
+		void run	( const size_t range_count, const std::function<void( size_t )>& task );
+		void work	( const size_t worker );
+
+		std::vector<std::thread>				m_threads;
+		std::mutex								m_mutex;
+		std::condition_variable					m_start;		// a stage was started or the pool is stopping
+		std::condition_variable					m_finish;		// the last worker of a stage is done
+		const std::function<void( size_t )>*	m_task = nullptr;
+		size_t									m_range_count = 0u;
+		size_t									m_stage = 0u;	// stages started so far
+		size_t									m_pending = 0u;	// workers of the stage still running
+		bool									m_stop = false;
+	};
+
+	// rays traced by every stage, for the report
+	struct WaveStats
+	{
+		size_t	waves = 0u;
+		size_t	rays = 0u;
+		size_t	shadow_rays = 0u;
+		size_t	batches = 0u;
+
+		size_t	ray_nodes = 0u;		// hierarchy nodes visited by the extend and connect stages
+		size_t	shadow_nodes = 0u;	// (only counted when built with CS500_TRAVERSAL_STATS)
+	};
+
+	/**
+	* @brief resize every array of the queue
+	* @param count
+	*/
+	void RayQueue::resize( const size_t count )
+	{
+		pos_x.resize( count ); pos_y.resize( count ); pos_z.resize( count );
+		dir_x.resize( count ); dir_y.resize( count ); dir_z.resize( count );
+		weight.resize( count );
+		e_permittivity.resize( count );
+		m_permeability.resize( count );
+		pixel.resize( count );
+		depth.resize( count );
+		rng.resize( count );
+		sample.resize( count );
+		dimension.resize( count );
+		hits.resize( count );
+	}
+
+	/**
+	* @brief empty the queue, the memory is kept for the next bounce
+	*/
+	void RayQueue::clear()
+	{
+		resize( 0u );
+	}
+
+	/**
+	* @brief add a ray at the end of the queue
+	* @param ray
+	* @param ray_weight		fraction of the light of the ray that reaches the pixel
+	* @param e				electric permittivity of the medium
+	* @param m				magnetic permeability of the medium
+	* @param ray_pixel
+	* @param ray_depth
+	* @param ray_rng
+	* @param ray_sample		camera sample of the pixel
+	* @param ray_dimension	next sampler dimension of the camera sample
+	*/
+	void RayQueue::push( const Shapes::Ray& ray, const vec3& ray_weight, const float e, const float m, const unsigned ray_pixel, const int ray_depth, const Random& ray_rng, const unsigned ray_sample, const unsigned ray_dimension )
+	{
+		pos_x.push_back( ray.pos.x ); pos_y.push_back( ray.pos.y ); pos_z.push_back( ray.pos.z );
+		dir_x.push_back( ray.dir.x ); dir_y.push_back( ray.dir.y ); dir_z.push_back( ray.dir.z );
+		weight.push_back( ray_weight );
+		e_permittivity.push_back( e );
+		m_permeability.push_back( m );
+		pixel.push_back( ray_pixel );
+		depth.push_back( ray_depth );
+		rng.push_back( ray_rng );
+		sample.push_back( ray_sample );
+		dimension.push_back( ray_dimension );
+		hits.emplace_back();
+	}
+
+	/**
+	* @brief store a ray in the queue
+	* @param i				position in the queue
+	* @param ray
+	* @param ray_weight		fraction of the light of the ray that reaches the pixel
+	* @param e				electric permittivity of the medium
+	* @param m				magnetic permeability of the medium
+	* @param ray_pixel
+	* @param ray_depth
+	* @param ray_rng
+	* @param ray_sample		camera sample of the pixel
+	* @param ray_dimension	next sampler dimension of the camera sample
+	*/
+	void RayQueue::set( const size_t i, const Shapes::Ray& ray, const vec3& ray_weight, const float e, const float m, const unsigned ray_pixel, const int ray_depth, const Random& ray_rng, const unsigned ray_sample, const unsigned ray_dimension )
+	{
+		pos_x[i] = ray.pos.x; pos_y[i] = ray.pos.y; pos_z[i] = ray.pos.z;
+		dir_x[i] = ray.dir.x; dir_y[i] = ray.dir.y; dir_z[i] = ray.dir.z;
+		weight[i] = ray_weight;
+		e_permittivity[i] = e;
+		m_permeability[i] = m;
+		pixel[i] = ray_pixel;
+		depth[i] = ray_depth;
+		rng[i] = ray_rng;
+		sample[i] = ray_sample;
+		dimension[i] = ray_dimension;
+		hits[i] = Intersection::Hit();
+	}
+
+	/**
+	* @brief add the rays of another queue at the end
+	* @param other
+	*/
+	void RayQueue::append( const RayQueue& other )
+	{
+		pos_x.insert( pos_x.end(), other.pos_x.begin(), other.pos_x.end() );
+		pos_y.insert( pos_y.end(), other.pos_y.begin(), other.pos_y.end() );
+		pos_z.insert( pos_z.end(), other.pos_z.begin(), other.pos_z.end() );
+		dir_x.insert( dir_x.end(), other.dir_x.begin(), other.dir_x.end() );
+		dir_y.insert( dir_y.end(), other.dir_y.begin(), other.dir_y.end() );
+		dir_z.insert( dir_z.end(), other.dir_z.begin(), other.dir_z.end() );
+		weight.insert( weight.end(), other.weight.begin(), other.weight.end() );
+		e_permittivity.insert( e_permittivity.end(), other.e_permittivity.begin(), other.e_permittivity.end() );
+		m_permeability.insert( m_permeability.end(), other.m_permeability.begin(), other.m_permeability.end() );
+		pixel.insert( pixel.end(), other.pixel.begin(), other.pixel.end() );
+		depth.insert( depth.end(), other.depth.begin(), other.depth.end() );
+		rng.insert( rng.end(), other.rng.begin(), other.rng.end() );
+		sample.insert( sample.end(), other.sample.begin(), other.sample.end() );
+		dimension.insert( dimension.end(), other.dimension.begin(), other.dimension.end() );
+		hits.insert( hits.end(), other.hits.begin(), other.hits.end() );
+	}
+
+	/**
+	* @brief replace the rays of the queue by a range of another one
+	* @param other
+	* @param begin		first ray
+	* @param end		last ray (excluded)
+	*/
+	void RayQueue::assign( const RayQueue& other, const size_t begin, const size_t end )
+	{
+		pos_x.assign( other.pos_x.begin() + begin, other.pos_x.begin() + end );
+		pos_y.assign( other.pos_y.begin() + begin, other.pos_y.begin() + end );
+		pos_z.assign( other.pos_z.begin() + begin, other.pos_z.begin() + end );
+		dir_x.assign( other.dir_x.begin() + begin, other.dir_x.begin() + end );
+		dir_y.assign( other.dir_y.begin() + begin, other.dir_y.begin() + end );
+		dir_z.assign( other.dir_z.begin() + begin, other.dir_z.begin() + end );
+		weight.assign( other.weight.begin() + begin, other.weight.begin() + end );
+		e_permittivity.assign( other.e_permittivity.begin() + begin, other.e_permittivity.begin() + end );
+		m_permeability.assign( other.m_permeability.begin() + begin, other.m_permeability.begin() + end );
+		pixel.assign( other.pixel.begin() + begin, other.pixel.begin() + end );
+		depth.assign( other.depth.begin() + begin, other.depth.begin() + end );
+		rng.assign( other.rng.begin() + begin, other.rng.begin() + end );
+		sample.assign( other.sample.begin() + begin, other.sample.begin() + end );
+		dimension.assign( other.dimension.begin() + begin, other.dimension.begin() + end );
+		hits.assign( other.hits.begin() + begin, other.hits.begin() + end );
+	}
+
+	/**
+	* @brief get a ray of the queue
+	* @param i
+	* @return ray
+	*/
+	Shapes::Ray RayQueue::ray( const size_t i ) const
+	{
+		return Shapes::Ray( vec3( pos_x[i], pos_y[i], pos_z[i] ), vec3( dir_x[i], dir_y[i], dir_z[i] ) );
+	}
+
+	/**
+	* @brief empty the queue, the memory is kept for the next bounce
+	*/
+	void ShadowQueue::clear()
+	{
+		pos_x.clear(); pos_y.clear(); pos_z.clear();
+		dir_x.clear(); dir_y.clear(); dir_z.clear();
+		t_max.clear();
+		color.clear();
+		pixel.clear();
+		visible.clear();
+	}
+
+	/**
+	* @brief add the light of a contact
+	* @param ray			from the contact to the light
+	* @param distance		distance to the light, 0 if it can not be blocked
+	* @param light			light added to the pixel
+	* @param light_pixel
+	*/
+	void ShadowQueue::push( const Shapes::Ray& ray, const float distance, const vec3& light, const unsigned light_pixel )
+	{
+		pos_x.push_back( ray.pos.x ); pos_y.push_back( ray.pos.y ); pos_z.push_back( ray.pos.z );
+		dir_x.push_back( ray.dir.x ); dir_y.push_back( ray.dir.y ); dir_z.push_back( ray.dir.z );
+		t_max.push_back( distance );
+		color.push_back( light );
+		pixel.push_back( light_pixel );
+		visible.push_back( 0 );
+	}
+
+	/**
+	* @brief add the entries of another queue at the end
+	* @param other
+	*/
+	void ShadowQueue::append( const ShadowQueue& other )
+	{
+		pos_x.insert( pos_x.end(), other.pos_x.begin(), other.pos_x.end() );
+		pos_y.insert( pos_y.end(), other.pos_y.begin(), other.pos_y.end() );
+		pos_z.insert( pos_z.end(), other.pos_z.begin(), other.pos_z.end() );
+		dir_x.insert( dir_x.end(), other.dir_x.begin(), other.dir_x.end() );
+		dir_y.insert( dir_y.end(), other.dir_y.begin(), other.dir_y.end() );
+		dir_z.insert( dir_z.end(), other.dir_z.begin(), other.dir_z.end() );
+		t_max.insert( t_max.end(), other.t_max.begin(), other.t_max.end() );
+		color.insert( color.end(), other.color.begin(), other.color.end() );
+		pixel.insert( pixel.end(), other.pixel.begin(), other.pixel.end() );
+		visible.insert( visible.end(), other.visible.begin(), other.visible.end() );
+	}
+
+	/**
+	* @brief get a ray of the queue
+	* @param i
+	* @return ray
+	*/
+	Shapes::Ray ShadowQueue::ray( const size_t i ) const
+	{
+		return Shapes::Ray( vec3( pos_x[i], pos_y[i], pos_z[i] ), vec3( dir_x[i], dir_y[i], dir_z[i] ) );
+	}
+
+	/**
+	* @brief start the worker threads
+	* @param thread_count	threads running the ranges, with the one of the caller
+	*/
+	WorkerPool::WorkerPool( const unsigned thread_count )
+	{
+		for ( size_t i = 1u; i < std::max( thread_count, 1u ); i++ )
+			m_threads.emplace_back( [this, i]() { work( i ); } );
+	}
+
+	/**
+	* @brief stop and join the worker threads
+	*/
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_stop = true;
+		}
+		m_start.notify_all();
+
+		for ( auto& thread : m_threads )
+			thread.join();
+	}
+
+	/**
+	* @brief run a function over contiguous ranges of a queue, one thread per range
+	* @param count		size of the queue
+	* @param function	called with the index of the range, its first and its last (excluded) element
+	* @return amount of ranges
+	*/
+	template <typename Function>
+	size_t WorkerPool::for_each_range( const size_t count, const Function& function )
+	{
+		const size_t range_count = std::clamp<size_t>( count / min_range_size, 1u, thread_count() );
+
+		// a single range does not wake the workers
+		if ( range_count == 1u )
+		{
+			function( 0u, 0u, count );
+			return 1u;
+		}
+
+		run( range_count, [&function, count, range_count]( const size_t i ) { function( i, count * i / range_count, count * ( i + 1u ) / range_count ); } );
+		return range_count;
+	}
+
+	/**
+	* @brief run a task on the workers below a range count and on the caller, and wait for all of them
+	* @param range_count	ranges of the stage, the caller takes the first one
+	* @param task			called with the index of the range
+	*/
+	void WorkerPool::run( const size_t range_count, const std::function<void( size_t )>& task )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_mutex );
+			m_task = &task;
+			m_range_count = range_count;
+			m_pending = range_count - 1u;
+			m_stage++;
+		}
+		m_start.notify_all();
+
+		task( 0u );
+
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_finish.wait( lock, [this]() { return m_pending == 0u; } );
+		m_task = nullptr;
+	}
+
+	/**
+	* @brief loop of a worker thread, runs its range of every stage until the pool stops
+	* @param worker		index of the range of the thread
+	*/
+	void WorkerPool::work( const size_t worker )
+	{
+		size_t stage = 0u;
+
+		std::unique_lock<std::mutex> lock( m_mutex );
+		while ( true )
+		{
+			m_start.wait( lock, [this, stage]() { return m_stop || m_stage != stage; } );
+			if ( m_stop )
+				return;
+
+			// the workers past the ranges of the stage go back to sleep
+			stage = m_stage;
+			if ( worker >= m_range_count )
+				continue;
+
+			const std::function<void( size_t )>& task = *m_task;
+			lock.unlock();
+			task( worker );
+			lock.lock();
+
+			if ( --m_pending == 0u )
+				m_finish.notify_one();
+		}
+	}
+
+	/**
+	* @brief spread the 9 lower bits of a value so there are two zeros between them
+	* @param value
+	* @return bits 0, 3, 6... of the result
+	*/
+	uint32_t spread_bits( uint32_t value )
+	{
+		value &= 0x1FFu;
+		value = ( value | ( value << 16u ) ) & 0x030000FFu;
+		value = ( value | ( value << 8u ) ) & 0x0300F00Fu;
+		value = ( value | ( value << 4u ) ) & 0x030C30C3u;
+		value = ( value | ( value << 2u ) ) & 0x09249249u;
+		return value;
+	}
+
+	/**
+	* @brief get the order in which a stage traces the rays of a queue
+	*
+	* The key of a ray is the octant of its direction followed by the Morton code of its origin in the
+	* bounds of all the origins of the queue, so rays going the same way from close points are traced
+	* one after the other and share the nodes in the caches (and the packets). The rays keep their place
+	* in the queue, the results are written where they were and the image does not change.
+	* @param queue	rays (RayQueue or ShadowQueue)
+	* @param order	indices of the rays in tracing order (return)
+	* @param workers	threads computing the keys
+	*/
+	template <typename Queue>
+	void sort_rays( const Queue& queue, std::vector<unsigned>& order, WorkerPool& workers )
+	{
+		const size_t count = queue.size();
+
+		vec3 min_pos( std::numeric_limits<float>::max() );
+		vec3 max_pos( std::numeric_limits<float>::lowest() );
+		for ( size_t i = 0u; i < count; i++ )
+		{
+			const vec3 pos( queue.pos_x[i], queue.pos_y[i], queue.pos_z[i] );
+			min_pos = glm::min( min_pos, pos );
+			max_pos = glm::max( max_pos, pos );
+		}
+
+		// 9 bits per axis
+		const vec3 scale = 511.0f / glm::max( max_pos - min_pos, vec3( 1e-6f ) );
+
+		// key in the high half, index in the low one -> one sort of plain integers, same order every time
+		std::vector<uint64_t> keys( count );
+		workers.for_each_range( count, [&]( const size_t, const size_t begin, const size_t end )
+		{
+			for ( size_t i = begin; i < end; i++ )
+			{
+				const glm::uvec3 cell = glm::uvec3( ( vec3( queue.pos_x[i], queue.pos_y[i], queue.pos_z[i] ) - min_pos ) * scale );
+				const uint32_t octant = ( queue.dir_x[i] < 0.0f ? 4u : 0u ) | ( queue.dir_y[i] < 0.0f ? 2u : 0u ) | ( queue.dir_z[i] < 0.0f ? 1u : 0u );
+				const uint32_t morton = ( spread_bits( cell.x ) << 2u ) | ( spread_bits( cell.y ) << 1u ) | spread_bits( cell.z );
+
+				keys[i] = ( static_cast<uint64_t>( ( octant << 27u ) | morton ) << 32u ) | i;
+			}
+		} );
+
+		std::sort( keys.begin(), keys.end() );
+
+		order.resize( count );
+		for ( size_t i = 0u; i < count; i++ )
+			order[i] = static_cast<uint32_t>( keys[i] );
+	}
+
+	/**
+	* @brief create a sequence for a new ray from the one of the ray spawning it
+	* @param rng	sequence of the parent ray
+	* @param pixel	pixel of the rays
+	* @return sequence of the new ray
+	*/
+	Random fork( Random& rng, const unsigned pixel )
+	{
+		const uint64_t seed = ( static_cast<uint64_t>( rng.next() ) << 32u ) | rng.next();
+		return Random( seed, pixel );
+	}
+
+	/**
+	* @brief generate stage, the camera rays of every sample of a range of pixels
+	* @param queue		camera rays (return)
+	* @param scene
+	* @param config		raytracer values
+	* @param first		first pixel of the wave
+	* @param last		last pixel of the wave (excluded)
+	* @param workers	threads generating the rays
+	*/
+	void generate( RayQueue& queue, const CompiledScene& scene, const Configuration& config, const size_t first, const size_t last, WorkerPool& workers )
+	{
+		const int samples = Raytracer::pixel_samples( config );
+		const Lights::Air& air = scene.air();
+
+		queue.resize( config.depth > 0 ? ( last - first ) * samples : 0u );
+
+		workers.for_each_range( queue.size(), [&]( const size_t, const size_t begin, const size_t end )
+		{
+			for ( size_t r = begin; r < end; r++ )
+			{
+				const size_t pixel = first + r / samples;
+				const int sample = static_cast<int>( r % samples );
+				const int i = static_cast<int>( pixel / config.width );
+				const int j = static_cast<int>( pixel % config.width );
+
+				// every sample draws from its own sequence so the image does not depend on the threads
+				Random rng( config.seed, static_cast<uint64_t>( pixel ) * samples + sample );
+				Sampler sampler( config.sampler, config.seed, i, j, rng );
+				sampler.start( sample, samples );
+
+				Shapes::Ray ray = Raytracer::compute_camera_ray( scene.camera(), config, i, j, sample, sampler );
+
+				queue.set( r, ray, vec3( 1.0f ), air.electric_permitivity, air.magnetic_permeability, static_cast<unsigned>( pixel ), 0, rng, sample, sampler.dimension() );
+			}
+		} );
+	}
+
+	/**
+	* @brief extend stage, find the closest hit of every ray of the queue
+	* @param queue		rays, their hits are filled
+	* @param order		tracing order of the rays (empty for queue order)
+	* @param scene
+	* @param config		raytracer values
+	* @param workers	threads tracing the rays
+	* @return hierarchy nodes visited
+	*/
+	size_t extend( RayQueue& queue, const std::vector<unsigned>& order, const CompiledScene& scene, const Configuration& config, WorkerPool& workers )
+	{
+		std::atomic<size_t> visits( 0u );
+
+		workers.for_each_range( queue.size(), [&]( const size_t, const size_t begin, const size_t end )
+		{
+			const size_t start_visits = BVH::node_visits();
+
+			// neighbouring rays come from the same pixel or contact (or were sorted together) -> coherent packets
+			if ( config.packets == true )
+			{
+				for ( size_t first = begin; first < end; first += Packets::width() )
+				{
+					const size_t last = std::min<size_t>( first + Packets::width(), end );
+
+					Packets::RayPacket packet;
+					Intersection::Hit hits[Packets::max_width];
+					for ( size_t i = first; i < last; i++ )
+						packet.add( queue.ray( order.empty() ? i : order[i] ) );
+
+					scene.intersect_packet( packet, hits );
+
+					for ( size_t i = first; i < last; i++ )
+						queue.hits[order.empty() ? i : order[i]] = hits[i - first];
+				}
+			}
+			else
+			{
+				for ( size_t i = begin; i < end; i++ )
+				{
+					const size_t r = order.empty() ? i : order[i];
+					scene.intersect( queue.ray( r ), queue.hits[r] );
+				}
+			}
+
+			visits += BVH::node_visits() - start_visits;
+		} );
+
+		return visits;
+	}
+
+	/**
+	* @brief shade stage, compute the light of every contact and spawn the reflected and refracted rays
+	*
+	* The color of a contact in the recursive tracer is (absorbed light + transmission * refracted color +
+	* reflection * reflected colors) * air attenuation. The weights are carried by the rays instead, so
+	* every contact adds its own light to the pixel and the rays it spawns get its weight times the
+	* attenuation times their coefficient.
+	* @param queue		rays and their hits
+	* @param next		rays of the next bounce (return)
+	* @param shadows	light of the contacts, to be tested against the scene (return)
+	* @param scene
+	* @param config		raytracer values
+	* @param begin		first ray
+	* @param end		last ray (excluded)
+	*/
+	void shade( RayQueue& queue, RayQueue& next, ShadowQueue& shadows, const CompiledScene& scene, const Configuration& config, const size_t begin, const size_t end )
+	{
+		const Lights::Air& air = scene.air();
+
+		next.clear();
+		shadows.clear();
+
+		for ( size_t r = begin; r < end; r++ )
+		{
+			const Intersection::Hit& hit = queue.hits[r];
+			if ( hit.time == -1.0f )
+				continue;
+
+			const Shapes::Ray ray = queue.ray( r );
+			const Intersection::Contact contact = scene.contact( ray, hit );
+			const Material& material = contact.material;
+
+			const float e_permittivity = queue.e_permittivity[r];
+			const float m_permeability = queue.m_permeability[r];
+			const unsigned pixel = queue.pixel[r];
+			const int depth = queue.depth[r];
+			Random& rng = queue.rng[r];
+
+			// the sampler continues where the ray that reached the contact left it
+			Sampler sampler( config.sampler, config.seed, static_cast<int>( pixel / config.width ), static_cast<int>( pixel % config.width ), rng );
+			sampler.start( queue.sample[r], static_cast<unsigned>( Raytracer::pixel_samples( config ) ) );
+			sampler.set_dimension( queue.dimension[r] );
+
+			// medium on the other side, normal facing the ray
+			float next_e_permittivity = material.electric_permittivity;
+			float next_m_permeability = material.magnetic_permeability;
+
+			vec3 I = normalize( ray.dir );
+			vec3 N = normalize( contact.normal );
+			float cos_angle = -dot( I, N );
+
+			if ( cos_angle <= 0.0f )
+			{
+				next_e_permittivity = air.electric_permitivity;
+				next_m_permeability = air.magnetic_permeability;
+				N = -N;
+				cos_angle = -cos_angle;
+			}
+
+			const vec3 contact_point_out = contact.point + config.epsilon * N;
+			const vec3 contact_point_in = contact.point - config.epsilon * N;
+
+			// reflected, transmitted and absorbed fractions
+			float reflection = Raytracer::compute_reflection_coeff( e_permittivity, m_permeability, next_e_permittivity, next_m_permeability, cos_angle );
+			float transmission = 1.0f - reflection;
+			const float absortion = 1.0f - reflection * material.specular_reflection - transmission * material.specular_reflection;
+
+			reflection		*= material.specular_reflection;
+			transmission	*= material.specular_reflection;
+
+			// the air attenuation scales everything seen from the contact
+			const vec3 weight = queue.weight[r] * glm::pow( air.attenuation, vec3( length( contact.point - ray.pos ) ) );
+			const vec3 absorbed = weight * absortion;
+
+			// ambient light can not be blocked
+			shadows.push( Shapes::Ray( contact_point_out, N ), 0.0f, absorbed * scene.ambient().color * material.diffuse_color, pixel );
+
+			// one shadow ray per light sample, each one carries its share of the light
+			const vec3 r_dir = glm::reflect( ray.dir, contact.normal );
+			for ( auto& light : scene.lights() )
+			{
+				const float light_dist = length( light.pos - contact_point_out );
+				const vec3 l = normalize( light.pos - contact_point_out );
+
+				const vec3 diffuse = light.color * material.diffuse_color * glm::max( dot( l, contact.normal ), 0.0f );
+				const vec3 specular = material.specular_reflection * glm::max( std::pow( dot( r_dir, l ), material.specular_exponent ), 0.0f ) * material.diffuse_color;
+				const vec3 light_color = absorbed * ( diffuse + specular );
+
+				// the random points of a light are drawn together
+				const unsigned dimension = sampler.next_dimension( 2u );
+
+				if ( config.shadow_samples == 0 )
+				{
+					shadows.push( Shapes::Ray( contact_point_out, N ), 0.0f, light_color, pixel );
+					continue;
+				}
+
+				for ( int i = 0; i < config.shadow_samples; i++ )
+				{
+					// randomized point inside the light sphere
+					const vec3 pos = i == 0 ? light.pos : Raytracer::get_random_sample( light.pos, light.radius, sampler, dimension, i - 1, config.shadow_samples - 1 );
+					shadows.push( Shapes::Ray( contact_point_out, normalize( pos - contact_point_out ) ), light_dist, light_color / static_cast<float>( config.shadow_samples ), pixel );
+				}
+			}
+
+			// spawned rays past the maximum depth are black
+			if ( depth + 1 >= config.depth )
+				continue;
+
+			const int samples = material.roughness == 0.0f ? 1 : config.reflection_samples;
+			const unsigned reflection_dimension = sampler.next_dimension( 1u );
+
+			// path tracing: past the first bounce only one of the rays is followed
+			if ( config.path_tracing == true && depth > 0 )
+			{
+				const float branch_weight = reflection + transmission;
+				const float throughput = std::max( weight.x, std::max( weight.y, weight.z ) );
+
+				// russian roulette, the paths carrying little light stop early and the others carry more
+				const float survival = std::min( throughput * branch_weight, 1.0f );
+				if ( branch_weight <= 0.0f || sampler.next_float() >= survival )
+					continue;
+
+				const vec3 path_weight = weight * ( branch_weight / survival );
+
+				// the single ray continues the dimensions of the camera sample
+				if ( sampler.next_float() * branch_weight < transmission )
+				{
+					next.push( Raytracer::refraction_ray( ray, N, contact_point_in, e_permittivity, m_permeability, next_e_permittivity, next_m_permeability ),
+							   path_weight, next_e_permittivity, next_m_permeability, pixel, depth + 1, fork( rng, pixel ), queue.sample[r], sampler.dimension() );
+				}
+				else
+				{
+					// the mirror direction is one of the reflection samples
+					const bool mirror = sampler.next_float() * static_cast<float>( samples ) < 1.0f;
+					const Shapes::Ray reflected = Raytracer::reflection_ray( ray, N, contact_point_out, material.roughness, mirror, sampler, reflection_dimension, 0u, 1u );
+					next.push( reflected, path_weight, e_permittivity, m_permeability, pixel, depth + 1, fork( rng, pixel ), queue.sample[r], sampler.dimension() );
+				}
+				continue;
+			}
+
+			// branching rays would share the next dimensions, they take their values from their own sequences
+			if ( transmission > 0.0f )
+			{
+				next.push( Raytracer::refraction_ray( ray, N, contact_point_in, e_permittivity, m_permeability, next_e_permittivity, next_m_permeability ),
+						   weight * transmission, next_e_permittivity, next_m_permeability, pixel, depth + 1, fork( rng, pixel ), queue.sample[r], Samplers::max_dimensions );
+			}
+
+			// the first reflection sample goes in the mirror direction, the rough ones are drawn together
+			if ( reflection > 0.0f )
+			{
+				const vec3 reflection_weight = weight * reflection / static_cast<float>( samples );
+				next.push( Raytracer::reflection_ray( ray, N, contact_point_out, material.roughness, true, sampler, reflection_dimension, 0u, 1u ),
+						   reflection_weight, e_permittivity, m_permeability, pixel, depth + 1, fork( rng, pixel ), queue.sample[r], Samplers::max_dimensions );
+
+				// same directions as reflection_ray, mapped in batches
+				const int rough = samples - 1;
+				const vec3 mirror_dir = normalize( glm::reflect( ray.dir, N ) );
+				const float cos_max = Raytracer::reflection_cone( material.roughness );
+				for ( int first = 0; first < rough; first += reflection_batch )
+				{
+					const int batch = std::min( reflection_batch, rough - first );
+
+					float u[reflection_batch], v[reflection_batch];
+					for ( int k = 0; k < batch; k++ )
+					{
+						const vec2 direction = sampler.get_2d( reflection_dimension, static_cast<unsigned>( first + k ), static_cast<unsigned>( rough ) );
+						u[k] = direction.x;
+						v[k] = direction.y;
+					}
+
+					float x[reflection_batch], y[reflection_batch], z[reflection_batch];
+					Sampling::uniform_cone( u, v, mirror_dir, cos_max, x, y, z, static_cast<unsigned>( batch ) );
+
+					for ( int k = 0; k < batch; k++ )
+					{
+						next.push( Shapes::Ray( contact_point_out, vec3( x[k], y[k], z[k] ) ),
+								   reflection_weight, e_permittivity, m_permeability, pixel, depth + 1, fork( rng, pixel ), queue.sample[r], Samplers::max_dimensions );
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	* @brief connect stage, check which lights of the contacts are not blocked
+	* @param shadows	light of the contacts, the visible flags are filled
+	* @param order		tracing order of the shadow rays (empty for queue order)
+	* @param scene
+	* @param workers	threads tracing the shadow rays
+	* @return hierarchy nodes visited
+	*/
+	size_t connect( ShadowQueue& shadows, const std::vector<unsigned>& order, const CompiledScene& scene, WorkerPool& workers )
+	{
+		std::atomic<size_t> visits( 0u );
+
+		workers.for_each_range( shadows.size(), [&]( const size_t, const size_t begin, const size_t end )
+		{
+			const size_t start_visits = BVH::node_visits();
+
+			for ( size_t i = begin; i < end; i++ )
+			{
+				const size_t r = order.empty() ? i : order[i];
+				shadows.visible[r] = shadows.t_max[r] <= 0.0f || scene.occluded( shadows.ray( r ), shadows.t_max[r] ) == false;
+			}
+
+			visits += BVH::node_visits() - start_visits;
+		} );
+
+		return visits;
+	}
+
+	/**
+	* @brief accumulate stage, add the visible light to the pixels
+	* @param shadows	light of the contacts
+	* @param colors		sum of the samples of every pixel
+	*/
+	void accumulate( const ShadowQueue& shadows, std::vector<vec3>& colors )
+	{
+		// in queue order, the sums do not depend on the threads
+		for ( size_t i = 0u; i < shadows.size(); i++ )
+		{
+			if ( shadows.visible[i] )
+				colors[shadows.pixel[i]] += shadows.color[i];
+		}
+	}
+}
+
+namespace Raytracer
+{
+	/**
+	* @brief render the image with queues of rays processed stage by stage
+	*
+	* The pixels are rendered in waves of a few thousand camera rays. All the rays of a batch go
+	* through each stage before the next one starts: extend (closest hit), shade (light of the
+	* contacts and rays of the next bounce), connect (shadow rays) and accumulate, so every stage
+	* runs the same code over long arrays instead of mixing traversal, shading and shadows per ray.
+	* The batches are small enough for the rays and shadow entries they spawn to fit in a fixed
+	* budget, and the rays of a batch are finished before the next batch of its bounce, so the memory
+	* grows with the depth instead of with the branching of the rays.
+	* The result is the same as the recursive tracer on average, the random sequences are different.
+	* @param color_buffer		result color buffer in chars, updated after every wave
+	* @param scene				scene to render
+	* @param config				raytracer values
+	* @param terminate			flag to stop rendering
+	* @param preview			front end to show the image while rendering (nullptr for none)
+	*/
+	void trace_wavefront( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview )
+	{
+		auto start = std::chrono::steady_clock::now();
+
+		const size_t pixel_count = static_cast<size_t>( config.width ) * config.height;
+		const size_t wave_pixels = std::max<size_t>( wave_size / std::max( pixel_samples( config ), 1 ), 1u );
+
+		// most rays (refraction and reflection samples) and shadow entries (ambient and light samples) of a contact
+		const size_t rays_per_contact = 1u + static_cast<size_t>( std::max( config.reflection_samples, 1 ) );
+		const size_t shadows_per_contact = 1u + scene.lights().size() * static_cast<size_t>( std::max( config.shadow_samples, 1 ) );
+		const size_t batch_size = std::max<size_t>( batch_budget / std::max( rays_per_contact, shadows_per_contact ), 1u );
+
+		std::vector<vec3> colors( pixel_count, vec3( 0.0f ) );
+
+		// rays of every bounce still to be shaded, the camera rays first
+		std::vector<Bounce> bounces( static_cast<size_t>( std::max( config.depth, 1 ) ) );
+		RayQueue queue;
+		ShadowQueue shadows;
+
+		// threads of every stage, started once for the whole render
+		WorkerPool workers( TileScheduler::hardware_threads() );
+
+		// outputs of the shade stage, one per range
+		std::vector<RayQueue> next_ranges( workers.thread_count() );
+		std::vector<ShadowQueue> shadow_ranges( workers.thread_count() );
+
+		// tracing order of the rays of the batch and of the shadow rays, empty for queue order
+		std::vector<unsigned> ray_order;
+		std::vector<unsigned> shadow_order;
+
+		WaveStats stats;
+
+		for ( size_t first = 0u; first < pixel_count && terminate == false; first += wave_pixels )
+		{
+			const size_t last = std::min( first + wave_pixels, pixel_count );
+
+			generate( bounces[0u].rays, scene, config, first, last, workers );
+			bounces[0u].next = 0u;
+
+			// bounce of the batch being traced, deeper bounces are finished first
+			size_t level = 0u;
+			while ( true )
+			{
+				Bounce& bounce = bounces[level];
+				if ( bounce.next >= bounce.rays.size() )
+				{
+					if ( level == 0u )
+						break;
+					level--;
+					continue;
+				}
+
+				const size_t batch_end = std::min( bounce.next + batch_size, bounce.rays.size() );
+				queue.assign( bounce.rays, bounce.next, batch_end );
+				bounce.next = batch_end;
+
+				// the camera rays are already in pixel order
+				ray_order.clear();
+				if ( config.sort_rays == true && level > 0u )
+					sort_rays( queue, ray_order, workers );
+
+				stats.ray_nodes += extend( queue, ray_order, scene, config, workers );
+
+				const size_t range_count = workers.for_each_range( queue.size(), [&]( const size_t range, const size_t begin, const size_t end )
+				{
+					shade( queue, next_ranges[range], shadow_ranges[range], scene, config, begin, end );
+				} );
+
+				// a single range is taken as it is, the others are copied in order
+				shadows.clear();
+				if ( range_count == 1u )
+					std::swap( shadows, shadow_ranges[0u] );
+				else
+				{
+					for ( size_t i = 0u; i < range_count; i++ )
+						shadows.append( shadow_ranges[i] );
+				}
+
+				shadow_order.clear();
+				if ( config.sort_rays == true )
+					sort_rays( shadows, shadow_order, workers );
+
+				stats.shadow_nodes += connect( shadows, shadow_order, scene, workers );
+				accumulate( shadows, colors );
+
+				stats.rays += queue.size();
+				stats.shadow_rays += static_cast<size_t>( std::count_if( shadows.t_max.begin(), shadows.t_max.end(), []( const float t ) { return t > 0.0f; } ) );
+				stats.batches++;
+
+				// the rays spawned past the last bounce are never pushed
+				if ( level + 1u < bounces.size() )
+				{
+					Bounce& child = bounces[level + 1u];
+					child.rays.clear();
+					child.next = 0u;
+					if ( range_count == 1u )
+						std::swap( child.rays, next_ranges[0u] );
+					else
+					{
+						for ( size_t i = 0u; i < range_count; i++ )
+							child.rays.append( next_ranges[i] );
+					}
+
+					if ( child.rays.size() > 0u )
+						level++;
+				}
+			}
+
+			// the pixels of the wave have all their samples
+			for ( size_t pixel = first; pixel < last; pixel++ )
+				write_pixel( color_buffer, config, static_cast<int>( pixel / config.width ), static_cast<int>( pixel % config.width ), colors[pixel] / static_cast<float>( config.antialiasing_samples * config.dof_samples ) );
+
+			stats.waves++;
+
+			if ( preview != nullptr )
+			{
+				if ( preview->should_close() )
+					terminate = true;
+				else
+					preview->render( color_buffer );
+			}
+		}
+
+		std::cout << "Wavefront: " << stats.waves << " waves, " << stats.batches << " batches, " << stats.rays << " rays and "
+				  << stats.shadow_rays << " shadow rays in " << std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count() << " ms" << std::endl;
+
+		if ( BVH::counts_visits() )
+		{
+			std::cout << "Traversal" << ( config.sort_rays ? " (sorted rays): " : ": " )
+					  << static_cast<double>( stats.ray_nodes ) / std::max<size_t>( stats.rays, 1u ) << " nodes per ray, "
+					  << static_cast<double>( stats.shadow_nodes ) / std::max<size_t>( stats.shadow_rays, 1u ) << " nodes per shadow ray" << std::endl;
+		}
+	}
+}
@@ -0,0 +1,20 @@
+/* ---------------------------------------------------------------------------------------------------------
+Copyright (C) 2020 DigiPen Institute of Technology.
+Reproduction or disclosure of this file or its contents without the prior written
+consent of DigiPen Institute of Technology is prohibited.
+
+File Name: wavefront.h
+Author: Josu Cubero Ruiz de Gopegui, josu.cubero, 540001316
+Creation date: 10/17/2026
+----------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+#include "raytracer.h"
+#include <atomic>
+#include <vector>
+
+namespace Raytracer
+{
+	void trace_wavefront( std::vector<unsigned char>& color_buffer, const CompiledScene& scene, const Configuration& config, std::atomic<bool>& terminate, Preview* preview );
+}
@@ -11,19 +11,20 @@ Creation date: 02/17/2020
 #pragma once
 
 #include "math_utils.h"
+#include "preview.h"
 
 #include "opengl.h"
 #include <vector>
 
-class Window
+class Window : public Preview
 {
 public:
 
-	void initialize( const int width, const int height, const std::vector<unsigned char>& color_buffer );
-	void render( const std::vector<unsigned char>& color_buffer );
-	void exit();
+	void initialize( const int width, const int height, const std::vector<unsigned char>& color_buffer ) override;
+	void render( const std::vector<unsigned char>& color_buffer ) override;
+	void exit() override;
 
-	bool should_close();
+	bool should_close() override;
 
 private:
 	unsigned compile_shader( const char* file, GLenum shader_type );